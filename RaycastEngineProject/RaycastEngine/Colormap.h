@@ -0,0 +1,43 @@
+#pragma once
+
+#include "SDL.h"
+#include "CustomMath.h"
+
+#define LIGHT_LEVELS	64 // level 0 is full brightness, the last one black
+
+// Doom style colormap for truecolor texels: the shaded value of every channel value at every light level,
+// so shading is a table lookup during the texel fetch instead of a multiply or a second blended pass
+typedef struct
+{
+	Uint8 channel[LIGHT_LEVELS][256];
+	Uint8 light[LIGHT_LEVELS]; // brightness of each level, for renderers that modulate colors instead
+
+} Colormap;
+
+void BuildColormap( Colormap* colormap )
+{
+	for ( int level = 0; level < LIGHT_LEVELS; level++ )
+	{
+		const int LIGHT			= 255 - ( level * 255 + ( LIGHT_LEVELS - 1 ) / 2 ) / ( LIGHT_LEVELS - 1 );
+		colormap->light[level]	= (Uint8)LIGHT;
+		for ( int value = 0; value < 256; value++ )
+		{
+			colormap->channel[level][value] = (Uint8)( ( value * LIGHT ) / 255 );
+		}
+	}
+
+} // BuildColormap()
+
+// Light level for a darkness of 0 ( none ) to 255 ( black )
+int DarknessToLightLevel( int darkness )
+{
+	return ( clampI( darkness, 0, 255 ) * ( LIGHT_LEVELS - 1 ) + 127 ) / 255;
+
+} // DarknessToLightLevel()
+
+// Shade a texel with one light level's row of the colormap, alpha is kept
+Uint32 ApplyColormap( const Uint8* levelRow, Uint32 color )
+{
+	return ( color & 0xFF000000u ) | ( (Uint32)levelRow[ ( color >> 16 ) & 0xFF ] << 16 ) | ( (Uint32)levelRow[ ( color >> 8 ) & 0xFF ] << 8 ) | levelRow[ color & 0xFF ];
+
+} // ApplyColormap()
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <math.h>
+#include <string.h>
+#include "CustomMath.h"
+#include "RayPacket.h"
+
+// Per column ray inputs. The camera-space coordinates only depend on the column count and are built once,
+// the ray directions and the DDA terms derived from them are refreshed every frame, a packet of columns at a time
+typedef struct
+{
+	int		columnCount;
+	int		laneCount; // columnCount rounded up to whole packets
+	int		laneCapacity; // lanes allocated per array, fewer columns reuse them
+	double*	block; // one packet aligned allocation the arrays below point into
+	double*	cameraCoord; // x in camera space, -1 at the first column
+	double*	rayDirX;
+	double*	rayDirY;
+	double*	deltaDistX; // as RayState.deltaDist
+	double*	deltaDistY;
+	double*	dirLength; // length of the ray direction
+
+} ColumnRays;
+
+void FreeColumnRays( ColumnRays* rays )
+{
+	_mm_free( rays->block );
+	memset( rays, 0, sizeof *rays );
+
+} // FreeColumnRays()
+
+// Room for at least laneCount lanes, only allocates when the current block is too small
+int ReserveColumnRays( ColumnRays* rays, int laneCount )
+{
+	if ( laneCount <= rays->laneCapacity )
+	{
+		return TRUE;
+	}
+
+	FreeColumnRays( rays );
+	rays->block = _mm_malloc( sizeof(double) * laneCount * 6, 32 );
+	if ( rays->block == NULL )
+	{
+		return FALSE;
+	}
+
+	rays->laneCapacity	= laneCount;
+	rays->cameraCoord	= rays->block;
+	rays->rayDirX		= rays->block + laneCount;
+	rays->rayDirY		= rays->block + laneCount * 2;
+	rays->deltaDistX	= rays->block + laneCount * 3;
+	rays->deltaDistY	= rays->block + laneCount * 4;
+	rays->dirLength		= rays->block + laneCount * 5;
+	return TRUE;
+
+} // ReserveColumnRays()
+
+// Camera-space coordinates of columnCount columns. Built at the window's column count, a lower internal resolution
+// refills the same block in place
+int BuildColumnRays( ColumnRays* rays, int columnCount )
+{
+	const int LANES = ( columnCount + RAY_PACKET_SIZE - 1 ) / RAY_PACKET_SIZE * RAY_PACKET_SIZE;
+	if ( !ReserveColumnRays( rays, LANES ) )
+	{
+		return FALSE;
+	}
+
+	rays->columnCount	= columnCount;
+	rays->laneCount		= LANES;
+
+	// Lanes past the last column get coordinates too, so whole packets stay finite
+	for ( int i = 0; i < LANES; i++ )
+	{
+		rays->cameraCoord[i] = ( 2 * ( i / (double)columnCount ) ) - 1;
+	}
+	return TRUE;
+
+} // BuildColumnRays()
+
+// Direction of every column's ray as one fused multiply-add per lane ( direction + cameraPlane * cameraCoord ),
+// followed by the divisions and square roots of all columns in one batch. The coordinate table is refilled when
+// the column count changed, returns FALSE when that needed a larger block and allocating it failed
+int UpdateColumnRays( ColumnRays* rays, int columnCount, Vec2 direction, Vec2 cameraPlane )
+{
+	if ( rays->columnCount != columnCount && !BuildColumnRays( rays, columnCount ) )
+	{
+		return FALSE;
+	}
+
+	const PacketD ONE		= PacketSet1( 1.0 );
+	const PacketD DIR_X		= PacketSet1( direction.x );
+	const PacketD DIR_Y		= PacketSet1( direction.y );
+	const PacketD PLANE_X	= PacketSet1( cameraPlane.x );
+	const PacketD PLANE_Y	= PacketSet1( cameraPlane.y );
+	for ( int i = 0; i < rays->laneCount; i += DOUBLE_LANES )
+	{
+		PacketD coord		= PacketLoad( rays->cameraCoord + i );
+		PacketD rayDirX		= PacketFma( PLANE_X, coord, DIR_X );
+		PacketD rayDirY		= PacketFma( PLANE_Y, coord, DIR_Y );
+		PacketD squaredX	= PacketMul( rayDirX, rayDirX );
+		PacketD squaredY	= PacketMul( rayDirY, rayDirY );
+
+		PacketStore( rays->rayDirX + i, rayDirX );
+		PacketStore( rays->rayDirY + i, rayDirY );
+		PacketStore( rays->deltaDistX + i, PacketSqrt( PacketAdd( ONE, PacketDiv( squaredY, squaredX ) ) ) );
+		PacketStore( rays->deltaDistY + i, PacketSqrt( PacketAdd( ONE, PacketDiv( squaredX, squaredY ) ) ) );
+		PacketStore( rays->dirLength + i, PacketSqrt( PacketAdd( squaredX, squaredY ) ) );
+	}
+	return TRUE;
+
+} // UpdateColumnRays()
+
+Vec2 ColumnRayDir( const ColumnRays* rays, int column )
+{
+	return vec2( rays->rayDirX[column], rays->rayDirY[column] );
+
+} // ColumnRayDir()
+
+Vec2 ColumnDeltaDist( const ColumnRays* rays, int column )
+{
+	return vec2( rays->deltaDistX[column], rays->deltaDistY[column] );
+
+} // ColumnDeltaDist()
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <stdlib.h>
+#include <string.h>
+#include "SDL.h"
+#include "CustomMath.h"
+#include "Occupancy.h"
+
+#define MAX_WALL_DISTANCE	255 // farther cells store this, which is still a safe lower bound
+
+// Per cell Chebyshev distance to the nearest wall ( 0 on walls ), the area outside the map counts as wall
+typedef struct
+{
+	int		width, height;
+	Uint8*	cells; // row-major
+	int		isBuilt; // kept up to date by UpdateDistanceField() once built
+
+} DistanceField;
+
+int AllocateDistanceField( DistanceField* field, int width, int height )
+{
+	free( field->cells );
+	field->width	= width;
+	field->height	= height;
+	field->isBuilt	= FALSE;
+	field->cells	= malloc( (size_t)width * height );
+	return field->cells != NULL;
+
+} // AllocateDistanceField()
+
+void FreeDistanceField( DistanceField* field )
+{
+	free( field->cells );
+	memset( field, 0, sizeof *field );
+
+} // FreeDistanceField()
+
+int GetWallDistance( const DistanceField* field, int x, int y )
+{
+	if ( x < 0 || y < 0 || x >= field->width || y >= field->height )
+	{
+		return 0;
+	}
+	return field->cells[ (size_t)y * field->width + x ];
+
+} // GetWallDistance()
+
+// Two pass chamfer transform over [x0,x1]x[y0,y1]; cells around the window are read as fixed seeds
+void ChamferDistanceWindow( DistanceField* field, const OccupancyGrid* grid, int x0, int y0, int x1, int y1 )
+{
+	for ( int y = y0; y <= y1; y++ )
+	{
+		for ( int x = x0; x <= x1; x++ )
+		{
+			field->cells[ (size_t)y * field->width + x ] = IsOccupied( grid, x, y ) ? 0 : MAX_WALL_DISTANCE;
+		}
+	}
+
+	// Forward pass, neighbours above and to the left
+	for ( int y = y0; y <= y1; y++ )
+	{
+		for ( int x = x0; x <= x1; x++ )
+		{
+			Uint8* cell	= &field->cells[ (size_t)y * field->width + x ];
+			int nearest	= min( min( GetWallDistance( field, x - 1, y ), GetWallDistance( field, x - 1, y - 1 ) ),
+							   min( GetWallDistance( field, x, y - 1 ), GetWallDistance( field, x + 1, y - 1 ) ) );
+			*cell		= (Uint8)min( (int)*cell, nearest + 1 );
+		}
+	}
+
+	// Backward pass, neighbours below and to the right
+	for ( int y = y1; y >= y0; y-- )
+	{
+		for ( int x = x1; x >= x0; x-- )
+		{
+			Uint8* cell	= &field->cells[ (size_t)y * field->width + x ];
+			int nearest	= min( min( GetWallDistance( field, x + 1, y ), GetWallDistance( field, x + 1, y + 1 ) ),
+							   min( GetWallDistance( field, x, y + 1 ), GetWallDistance( field, x - 1, y + 1 ) ) );
+			*cell		= (Uint8)min( (int)*cell, nearest + 1 );
+		}
+	}
+
+} // ChamferDistanceWindow()
+
+void BuildDistanceField( DistanceField* field, const OccupancyGrid* grid )
+{
+	ChamferDistanceWindow( field, grid, 0, 0, field->width - 1, field->height - 1 );
+	field->isBuilt = TRUE;
+
+} // BuildDistanceField()
+
+// Incremental update after cell ( x, y ) changed, only the rings around it that are affected are touched
+void UpdateDistanceField( DistanceField* field, const OccupancyGrid* grid, int x, int y )
+{
+	if ( !field->isBuilt )
+	{
+		return;
+	}
+
+	if ( IsOccupied( grid, x, y ) )
+	{
+		// New wall: distances only shrink, ring by ring until a ring is left unchanged
+		field->cells[ (size_t)y * field->width + x ] = 0;
+		for ( int r = 1; r < MAX_WALL_DISTANCE; r++ )
+		{
+			int changed = FALSE;
+			for ( int cy = max( y - r, 0 ); cy <= min( y + r, field->height - 1 ); cy++ )
+			{
+				int onEdge	= ( cy == y - r || cy == y + r );
+				int stepX	= onEdge ? 1 : 2 * r;
+				for ( int cx = x - r; cx <= x + r; cx += stepX )
+				{
+					Uint8* cell = ( cx >= 0 && cx < field->width ) ? &field->cells[ (size_t)cy * field->width + cx ] : NULL;
+					if ( cell != NULL && *cell > r )
+					{
+						*cell	= (Uint8)r;
+						changed	= TRUE;
+					}
+				}
+			}
+			if ( !changed )
+			{
+				break;
+			}
+		}
+		return;
+	}
+
+	// Removed wall: cells that had it as nearest wall sit at exactly their ring distance, and stop once a ring has none
+	int radius = 0;
+	for ( int r = 1; r < MAX_WALL_DISTANCE; r++ )
+	{
+		int affected = FALSE;
+		for ( int cy = max( y - r, 0 ); cy <= min( y + r, field->height - 1 ) && !affected; cy++ )
+		{
+			int onEdge	= ( cy == y - r || cy == y + r );
+			int stepX	= onEdge ? 1 : 2 * r;
+			for ( int cx = x - r; cx <= x + r; cx += stepX )
+			{
+				if ( cx >= 0 && cx < field->width && field->cells[ (size_t)cy * field->width + cx ] == r )
+				{
+					affected = TRUE;
+					break;
+				}
+			}
+		}
+		if ( !affected )
+		{
+			break;
+		}
+		radius = r;
+	}
+
+	// Recompute the affected square, the unchanged ring around it seeds the transform
+	ChamferDistanceWindow( field, grid, max( x - radius, 0 ), max( y - radius, 0 ), min( x + radius, field->width - 1 ), min( y + radius, field->height - 1 ) );
+
+} // UpdateDistanceField()
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <math.h>
+#include <emmintrin.h>
+#include "SDL.h"
+#include "CustomMath.h"
+#include "Colormap.h"
+
+#define FLOOR_LANES		4 // pixels whose texture coordinates are stepped together
+
+// One screen row of floor. The floor is flat, so every pixel of the row is at the same distance and the
+// world position moves by a constant step per pixel. u and v are the position within its cell in 0.32 fixed
+// point, so the wrap to the next floor tile is plain integer overflow and never needs a floor() or modulo
+typedef struct
+{
+	Uint32 u, v;
+	Uint32 uStep, vStep;
+
+} FloorRow;
+
+// Screen rows [top, bottom) a wall ( or fog ) covers in one pixel column, the floor and ceiling are only written outside it
+typedef struct
+{
+	int top, bottom;
+
+} WallSpan;
+
+// Cell fraction of a map coordinate in 0.32 fixed point, negative values wrap the same way as positive ones
+Uint32 FloorFraction( double x )
+{
+	double fraction = ( x - floor( x ) ) * 4294967296.0;
+	return ( fraction >= 4294967295.0 ) ? 0xFFFFFFFFu : (Uint32)fraction;
+
+} // FloorFraction()
+
+// start is the map position ( in cells ) under the row's first pixel, step the move from one pixel to the next
+FloorRow SetupFloorRow( Vec2 start, Vec2 step )
+{
+	FloorRow row;
+	row.u		= FloorFraction( start.x );
+	row.v		= FloorFraction( start.y );
+	row.uStep	= FloorFraction( step.x );
+	row.vStep	= FloorFraction( step.y );
+	return row;
+
+} // SetupFloorRow()
+
+// Texture the floor row at screen row floorY into floorDst, and the ceiling row at ceilingY into ceilingDst when given,
+// since the ceiling row mirrored across the horizon sees exactly the same cells. Texture coordinates for FLOOR_LANES
+// pixels are stepped and turned into texel indices per SSE2 vector; texture sizes up to 32767 work. A NULL light row
+// leaves that surface unshaded, with spans only pixels outside their column's wall are written. Returns pixels written
+int CastFloorRow( const FloorRow* row, const Uint32* texels, int texWidth, int texHeight, int width, const WallSpan* spans,
+				  int floorY, Uint32* floorDst, const Uint8* floorLight, int ceilingY, Uint32* ceilingDst, const Uint8* ceilingLight )
+{
+	// Lane k starts k steps in, every vector then moves FLOOR_LANES steps
+	__m128i u			= _mm_setr_epi32( (int)row->u, (int)( row->u + row->uStep ), (int)( row->u + 2 * row->uStep ), (int)( row->u + 3 * row->uStep ) );
+	__m128i v			= _mm_setr_epi32( (int)row->v, (int)( row->v + row->vStep ), (int)( row->v + 2 * row->vStep ), (int)( row->v + 3 * row->vStep ) );
+	const __m128i U_STEP	= _mm_set1_epi32( (int)( row->uStep * FLOOR_LANES ) );
+	const __m128i V_STEP	= _mm_set1_epi32( (int)( row->vStep * FLOOR_LANES ) );
+
+	// Texel = top 16 bits of the fraction times the size. With the size only in the low half of each 32 bit lane,
+	// the unsigned 16 bit high multiply gives exactly that and leaves the upper half zero
+	const __m128i TEX_W		= _mm_set1_epi32( texWidth );
+	const __m128i TEX_H		= _mm_set1_epi32( texHeight );
+	const __m128i PITCH		= _mm_set1_epi32( texWidth | ( 1 << 16 ) ); // index = texY * texWidth + texX * 1
+
+	ALIGNED(16) Sint32 index[FLOOR_LANES];
+	int written = 0;
+	for ( int x = 0; x < width; x += FLOOR_LANES )
+	{
+		__m128i texX	= _mm_mulhi_epu16( _mm_srli_epi32( u, 16 ), TEX_W );
+		__m128i texY	= _mm_mulhi_epu16( _mm_srli_epi32( v, 16 ), TEX_H );
+		_mm_store_si128( (__m128i*)index, _mm_madd_epi16( _mm_or_si128( texY, _mm_slli_epi32( texX, 16 ) ), PITCH ) );
+		u				= _mm_add_epi32( u, U_STEP );
+		v				= _mm_add_epi32( v, V_STEP );
+
+		const int COUNT = min( width - x, FLOOR_LANES );
+		for ( int k = 0; k < COUNT; k++ )
+		{
+			const int PX	= x + k;
+			Uint32 texel	= texels[ index[k] ];
+			if ( spans == NULL || floorY >= spans[PX].bottom )
+			{
+				floorDst[PX] = floorLight ? ApplyColormap( floorLight, texel ) : texel;
+				written++;
+			}
+			if ( ceilingDst != NULL && ( spans == NULL || ceilingY < spans[PX].top ) )
+			{
+				ceilingDst[PX] = ceilingLight ? ApplyColormap( ceilingLight, texel ) : texel;
+				written++;
+			}
+		}
+	}
+	return written;
+
+} // CastFloorRow()
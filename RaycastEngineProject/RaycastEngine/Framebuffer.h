@@ -0,0 +1,131 @@
+#pragma once
+
+#include <stdlib.h>
+#include <string.h>
+#include <emmintrin.h>
+#include "SDL.h"
+#include "CustomMath.h"
+
+// Pixel layout shared by the Framebuffer and the CPU copies of Images
+#define FRAMEBUFFER_FORMAT	SDL_PIXELFORMAT_ARGB8888
+#define FRAMEBUFFER_ALIGN	64 // every row starts on a cache line, so strips of whole lines can be written by different threads
+
+// CPU side pixel buffer, written directly and uploaded once per frame
+typedef struct
+{
+	Uint32*			pixels;
+	int				width;
+	int				height;
+	int				pitch; // in pixels, not bytes
+	int				maxWidth, maxHeight; // allocated size, width and height can be set below it, see SetFramebufferSize()
+	SDL_Texture*	texture; // streaming texture the pixels are uploaded through
+
+} Framebuffer;
+
+Uint32 PackColor( Uint8 r, Uint8 g, Uint8 b )
+{
+	return ( 0xFFu << 24 ) | ( (Uint32)r << 16 ) | ( (Uint32)g << 8 ) | (Uint32)b;
+
+} // PackColor()
+
+int CreateFramebuffer( SDL_Renderer* renderer, Framebuffer* frameBuffer, int width, int height )
+{
+	memset( frameBuffer, 0, sizeof *frameBuffer );
+	const int LINE_PIXELS	= FRAMEBUFFER_ALIGN / sizeof(Uint32);
+	const int PITCH			= ( width + LINE_PIXELS - 1 ) / LINE_PIXELS * LINE_PIXELS;
+	frameBuffer->pixels		= _mm_malloc( sizeof(Uint32) * PITCH * height, FRAMEBUFFER_ALIGN );
+	if ( frameBuffer->pixels == NULL )
+	{
+		return FALSE;
+	}
+	frameBuffer->width		= width;
+	frameBuffer->height		= height;
+	frameBuffer->pitch		= PITCH;
+	frameBuffer->maxWidth	= width;
+	frameBuffer->maxHeight	= height;
+
+	if ( renderer != NULL )
+	{
+		frameBuffer->texture = SDL_CreateTexture( renderer, FRAMEBUFFER_FORMAT, SDL_TEXTUREACCESS_STREAMING, width, height );
+		if ( frameBuffer->texture == NULL )
+		{
+			printf("Cannot create Framebuffer texture: %s \n\n", SDL_GetError() );
+			return FALSE;
+		}
+	}
+	return TRUE;
+
+} // CreateFramebuffer()
+
+void DestroyFramebuffer( Framebuffer* frameBuffer )
+{
+	if ( frameBuffer->texture != NULL )
+	{
+		SDL_DestroyTexture( frameBuffer->texture );
+	}
+	_mm_free( frameBuffer->pixels );
+	memset( frameBuffer, 0, sizeof *frameBuffer );
+
+} // DestroyFramebuffer()
+
+// Render into the top left width x height of the allocation, presenting stretches that to the whole target
+void SetFramebufferSize( Framebuffer* frameBuffer, int width, int height )
+{
+	frameBuffer->width	= clampI( width, 1, frameBuffer->maxWidth );
+	frameBuffer->height	= clampI( height, 1, frameBuffer->maxHeight );
+
+} // SetFramebufferSize()
+
+// Returns the number of pixels written after clipping
+int FillFramebufferRect( Framebuffer* frameBuffer, int x, int y, int w, int h, Uint32 color )
+{
+	int startX	= clampI( x, 0, frameBuffer->width );
+	int endX	= clampI( x + w, 0, frameBuffer->width );
+	int startY	= clampI( y, 0, frameBuffer->height );
+	int endY	= clampI( y + h, 0, frameBuffer->height );
+
+	for ( int row = startY; row < endY; row++ )
+	{
+		Uint32* dst = frameBuffer->pixels + row * frameBuffer->pitch;
+		for ( int col = startX; col < endX; col++ )
+		{
+			dst[col] = color;
+		}
+	}
+	return max( endX - startX, 0 ) * max( endY - startY, 0 );
+
+} // FillFramebufferRect()
+
+// Draw what was last uploaded, without touching the pixels, stretched over the whole target
+void DrawFramebuffer( SDL_Renderer* renderer, Framebuffer* frameBuffer )
+{
+	SDL_Rect used = { 0, 0, frameBuffer->width, frameBuffer->height };
+	SDL_RenderCopy( renderer, frameBuffer->texture, &used, NULL );
+
+} // DrawFramebuffer()
+
+// Single upload and single draw call for the whole frame, a smaller Framebuffer is upscaled to the target as it is drawn
+void PresentFramebuffer( SDL_Renderer* renderer, Framebuffer* frameBuffer )
+{
+	SDL_Rect used = { 0, 0, frameBuffer->width, frameBuffer->height };
+	SDL_UpdateTexture( frameBuffer->texture, &used, frameBuffer->pixels, frameBuffer->pitch * sizeof(Uint32) );
+	DrawFramebuffer( renderer, frameBuffer );
+
+} // PresentFramebuffer()
+
+// Copy the used width x height out as tightly packed 8 bit RGB, without the pitch padding
+void PackFramebufferRGB( const Framebuffer* frameBuffer, Uint8* rgb )
+{
+	for ( int row = 0; row < frameBuffer->height; row++ )
+	{
+		const Uint32* src = frameBuffer->pixels + row * frameBuffer->pitch;
+		for ( int col = 0; col < frameBuffer->width; col++ )
+		{
+			rgb[0]	= (Uint8)( src[col] >> 16 );
+			rgb[1]	= (Uint8)( src[col] >> 8 );
+			rgb[2]	= (Uint8)src[col];
+			rgb		+= 3;
+		}
+	}
+
+} // PackFramebufferRGB()
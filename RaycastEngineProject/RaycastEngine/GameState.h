@@ -0,0 +1,114 @@
+#pragma once
+
+#include "SDL.h"
+#include "CustomMath.h"
+#include "Map.h"
+#include "Player.h"
+#include "Framebuffer.h"
+#include "ColumnRays.h"
+#include "WallFaces.h"
+#include "Colormap.h"
+#include "FloorCasting.h"
+#include "ThreadPool.h"
+
+// Stores Texture and cached Texture info 
+typedef struct Image
+{
+	SDL_Texture* img;
+	Uint32*		 pixels; // CPU copy in FRAMEBUFFER_FORMAT for software rendering
+	Uint32*		 columns; // wall textures: the same texels column-major, every column a cache line aligned run
+	int			 columnPitch; // texels from the start of one column to the next
+	int			 width;
+	int			 height; 
+	struct Image* mips; // wall textures: halved copies, mips[0] at half this size, see BuildMipChain()
+	int			 mipCount;
+
+} Image;
+
+// Holds flags and dev values
+typedef struct
+{
+	int isFullscreen;
+	int texturedWalls;
+	int displayMap;
+	int drawRays;
+	int enabledLighting;
+	int softwareRender;
+	int traversal;
+	int coalesceFaces;
+	int frameCache;
+	int adaptiveColumns;
+	int farPlane;
+	int mipmaps;
+	int floorCasting;
+	int spanComposition;
+	int parallelRaster;
+	int dynamicResolution;
+
+} Debug;
+
+// Everything the 3D view depends on, frames with the same key look the same
+typedef struct
+{
+	Vec2	pos;
+	Vec2	direction;
+	Vec2	cameraPlane;
+	int		mapRevision;
+	VecI2	renderSize;
+	Debug	debug;
+
+} FrameKey;
+
+// Adjacent columns that hit the same face of the same cell, drawn as one trapezoid
+typedef struct
+{
+	int first, last; // columns, inclusive
+
+} FaceRun;
+
+// Contains all major elements for running the game
+typedef struct
+{
+	Player			player;
+
+	// Game Textures
+	Image			img_Checker;
+	Image			img_Wall;
+	Image			img_Floor;
+	Image			img_Hand;
+
+	SDL_Window*		window;
+	SDL_Renderer*	renderer;
+	Framebuffer		frameBuffer;
+	Hit*			columnHits; // Raycast results of the current frame, one per column
+	ColumnRays		columnRays; // ray direction through each column for the current frame
+	WallSweep		wallSweep; // wall faces for TRAVERSAL_SWEEP
+	FaceRun*		faceRuns; // current frame's columns merged by face, see CollectFaceRuns()
+	int				faceRunCount; // runs in faceRuns for the Framebuffer being rasterized
+	Framebuffer		wallLayer; // transparent layer the SDL path draws coalesced faces into
+	FrameKey		frameKey; // of the last frame drawn
+	int				isStaticFrame; // nothing changed since the last frame, its Hits and pixels are still valid
+	SDL_atomic_t	rayCount; // rays cast for the current frame
+	WallSpan*		wallSpans; // rows the wall covers in each pixel column of the current frame, see MarkWallSpan()
+	SDL_atomic_t	pixelWrites; // Framebuffer pixels written for the current frame, the overdraw counter of the software path
+	double			renderScale; // internal resolution of the Framebuffer path per axis, 1 is the window size
+	double			renderCost; // smoothed milliseconds casting and rasterizing a window sized frame would take, see UpdateRenderScale()
+	Colormap		colormap; // wall shading by light level
+	ThreadPool		threadPool;
+
+	Timer			timer;
+	GameMap			gameMap;
+	Debug			debug;
+
+	Uint8*			statePrev;
+
+} GameState;
+
+// Defined in Main.c, for the modules that drive the game's renderer ( VecEnv.h )
+void SetupGameState( GameState* game );
+void LoadGame( GameState* game, VecI2 viewSize );
+void UnloadGame( GameState* game );
+int CreateViewContext( GameState* view, const GameState* game, VecI2 size );
+void DestroyViewContext( GameState* view );
+void CastColumns( GameState* game, int columnCount );
+void RasterizeWorld( GameState* game );
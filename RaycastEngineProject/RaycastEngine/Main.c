@@ -1,665 +1,2648 @@
-#pragma once 
-
-#include <time.h>
-#include <stdlib.h>
-#include "SDL.h"
-#include "SDL_image.h"
-#include "Player.h"
-
-#define BENCHMARK			0
-
-// Environment Values
-#define	RAY_LENGTH			100
-#define	COLUMN_RATIO		1
-#define	WALL_SCALE			0.4f
-#define	DARKNESS_INTENSITY	15
-#define	REPEAT_WALL			2
-
-// Stores Texture and cached Texture info 
-typedef struct
-{
-	SDL_Texture* img;
-	int			 width;
-	int			 height; 
-
-} Image;
-
-// Holds flags and dev values
-typedef struct
-{
-	int isFullscreen;
-	int texturedWalls;
-	int displayMap;
-	int drawRays;
-	int enabledLighting;
-
-} Debug;
-
-// Contains all major elements for running the game
-typedef struct
-{
-	Player			player;
-
-	// Game Textures
-	Image			img_Checker;
-	Image			img_Wall;
-	Image			img_Floor;
-	Image			img_Hand;
-
-	SDL_Window*		window;
-	SDL_Renderer*	renderer;
-
-	Timer			timer;
-	GameMap			gameMap;
-	Debug			debug;
-
-	Uint8*			statePrev;
-
-} GameState;
-
-void EnableFullscreen( SDL_Window* window, Debug* debug )
-{
-	if ( debug->isFullscreen != SDL_WINDOW_FULLSCREEN)
-	{
-		debug->isFullscreen = SDL_WINDOW_FULLSCREEN;
-		SDL_SetWindowFullscreen( window, SDL_WINDOW_FULLSCREEN);
-	}
-
-} // EnableFullscreen()
-
-void DisableFullscreen( SDL_Window* window, Debug* debug )
-{
-	if ( debug->isFullscreen != 0 )
-	{
-		debug->isFullscreen = 0;
-		SDL_SetWindowFullscreen( window, 0);
-	}
-
-} // DisableFullscreen()
-
-void ProcessDebugInput( const Uint8* state, Uint8* statePrev, SDL_Window* window, Debug* debug )
-{
-	// Toggle Debug Displays
-	if ( state[SDL_SCANCODE_1] )
-	{
-		debug->texturedWalls = TRUE;
-	}
-	if (state[SDL_SCANCODE_2])
-	{
-		debug->texturedWalls = FALSE;
-	}
-	if (state[SDL_SCANCODE_3])
-	{
-		debug->enabledLighting = FALSE;
-	}
-	if (state[SDL_SCANCODE_4])
-	{
-		debug->enabledLighting = TRUE;
-	}
-	if (state[SDL_SCANCODE_9])
-	{
-		debug->drawRays = FALSE;
-	}
-	if (state[SDL_SCANCODE_0])
-	{
-		debug->drawRays = TRUE;
-	}
-	if (state[SDL_SCANCODE_M])
-	{
-		debug->displayMap	= TRUE;
-		debug->drawRays		= TRUE;
-	}
-	if (state[SDL_SCANCODE_N])
-	{
-		debug->displayMap	= FALSE;
-		debug->drawRays		= FALSE;
-	}
-	if (state[SDL_SCANCODE_F3])
-	{
-		DisableFullscreen( window, debug );
-	}
-	if (state[SDL_SCANCODE_F4])
-	{
-		EnableFullscreen(window, debug);
-	}
-
-} // ProcessDebugInput()
-
-int ProcessWindowEvents(SDL_Window* window)
-{
-	int done = FALSE;
-	SDL_Event event;
-
-	// Check for events
-	while ( SDL_PollEvent(&event) )
-	{
-		switch (event.type)
-		{
-		case SDL_WINDOWEVENT_CLOSE:
-		{
-			if (window)
-			{
-				SDL_DestroyWindow(window);
-				window	= NULL;
-				done	= TRUE;
-			}
-		}
-		break;
-		case SDL_KEYDOWN:
-		{
-			switch (event.key.keysym.sym)
-			{
-			case SDLK_ESCAPE:
-				done = TRUE;
-				break;
-			}
-		}
-		break;
-		case SDL_QUIT:
-			done = TRUE;
-			break;
-		}
-	}
-	return done;
-
-} // ProcessWindowEvents()
-
-int ProcessInputsAndEvents( GameState *game )
-{
-	int done = ProcessWindowEvents(game->window);
-
-	const Uint8* state = SDL_GetKeyboardState(NULL);
-	ProcessDebugInput(state, game->statePrev, game->window, &game->debug );
-	ProcessPlayerInput( state, &game->player, &game->gameMap, game->timer.deltaTime );
-
-	return done;
-
-} // ProcessInputsAndEvents()
-
-// Debug Displaying 2D Map
-void DrawMap(GameState *game)
-{
-	for (int i = 0; i < MAP_SIZE; i++) // Rows
-	{
-		for (int j = 0; j < MAP_SIZE; j++) // Columns
-		{
-			if ( game->gameMap.map[i][j] == FALSE)
-			{
-				continue;
-			}
-			SDL_Rect tileRect = { j * GRID_RES.x, i * GRID_RES.y, GRID_RES.x, GRID_RES.y };
-			SDL_RenderCopy(game->renderer, game->img_Checker.img, NULL, &tileRect);
-		} // for
-
-	} // for
-
-} // DrawMap()
-
-  // Draw Player on 2D Map ( including camera facing )
-void DebugDrawPlayer(GameState *game)
-{
-	// Debug Draw Player Dir
-	const float DIR_LENGTH = RESOLUTION.x / 10.0f;
-	Vec2 playerPos = { game->player.pos.x, game->player.pos.y };
-	Vec2 endPos = GetProjectedVector(&playerPos, &game->player.direction, -DIR_LENGTH);
-	SDL_SetRenderDrawColor(game->renderer, 255, 255, 0, SDL_ALPHA_OPAQUE);
-	SDL_RenderDrawLine(game->renderer, (int)playerPos.x, (int)playerPos.y, (int)endPos.x, (int)endPos.y);
-
-	// Debug Draw Camera Plane
-	Vec2 camStart = GetProjectedVector(&endPos, &game->player.cameraPlane, -DIR_LENGTH);
-	Vec2 camEnd = GetProjectedVector(&endPos, &game->player.cameraPlane, DIR_LENGTH);
-	SDL_SetRenderDrawColor(game->renderer, 0, 255, 255, SDL_ALPHA_OPAQUE);
-	SDL_RenderDrawLine(game->renderer, (int)camStart.x, (int)camStart.y, (int)camEnd.x, (int)camEnd.y);
-
-	// Draw Player Pos
-	SDL_SetRenderDrawColor(game->renderer, 0, 255, 0, 255);
-	double sizeHalf = game->player.debugSize / 2.0f;
-	SDL_Rect rect = { (int)(game->player.pos.x - sizeHalf), (int)(game->player.pos.y - sizeHalf), game->player.debugSize, game->player.debugSize };
-	SDL_RenderFillRect(game->renderer, &rect);
-
-} // DebugDrawPlayerDir()
-
-Hit Raycast(GameState *game, int column)
-{
-	// Initialize Hit ( Default )
-	Hit hit;
-	memset(&hit, 0, sizeof(hit) );
-
-	// Calculate Ray Position and Direction
-	const double COLUMN_TOTAL  = RESOLUTION.x * game->gameMap.columnRatio;
-	const double CAMERA_COORD  = (2 * ( column / COLUMN_TOTAL ) ) - 1; //x-coordinate in camera space
-
-	Vec2 rayDir			= GetProjectedVector(&game->player.direction, &game->player.cameraPlane, -CAMERA_COORD );
-	Vec2 rayEndPos		= { game->player.pos.x, game->player.pos.y }; // Current End Point of Ray that increments and tests for Hit
-
-	//which box of the map we're in
-	Vec2 mapPos = { game->player.pos.x / GRID_RES.x, game->player.pos.y / GRID_RES.y };
-
-	//length of ray from current position to next x or y-side
-	Vec2 sideDist;
-
-	//length of ray from one x or y-side to next x or y-side
-	Vec2 rayDirSquared		= { square(rayDir.x), square(rayDir.y) };
-	Vec2 deltaDist			= { sqrt(1 + rayDirSquared.y / rayDirSquared.x ), sqrt(1 + rayDirSquared.x / rayDirSquared.y ) };
-	double perpWallDist;
-
-	//what direction to step in x or y-direction (either +1 or -1)
-	VecI2 mapStep = { 0, 0 };
-
-	// Truncate Map Pos
-	int mapX = (int)mapPos.x;
-	int mapY = (int)mapPos.y;
-
-	//calculate step and initial sideDist
-	if (rayDir.x < 0)
-	{
-		mapStep.x	= -1;
-		sideDist.x	= (mapPos.x - mapX ) * deltaDist.x;
-	}
-	else
-	{
-		mapStep.x	= 1;
-		sideDist.x	= (mapX + 1.0 - mapPos.x) * deltaDist.x;
-	}
-	if (rayDir.y < 0)
-	{
-		mapStep.y	= -1;
-		sideDist.y	= (mapPos.y - mapY) * deltaDist.y;
-	}
-	else
-	{
-		mapStep.y	= 1;
-		sideDist.y	= (mapY + 1.0 - mapPos.y) * deltaDist.y;
-	}
-
-	//perform DDA
-	while (hit.isHit == FALSE)
-	{
-		//jump to next map square, OR in x-direction, OR in y-direction
-		if ( sideDist.x < sideDist.y )
-		{
-			sideDist.x	+= deltaDist.x;
-			mapX		+= mapStep.x;
-			rayEndPos.x += mapStep.x * GRID_RES.x;
-			hit.isSide	 = TRUE;
-		}
-		else
-		{
-			sideDist.y	+= deltaDist.y;
-			mapY		+= mapStep.y;
-			rayEndPos.y += mapStep.y * GRID_RES.y;
-			hit.isSide  = FALSE;
-		}
-
-		int xOut = (mapX < 0 || mapX > MAP_SIZE - 1);
-		int yOut = (mapY < 0 || mapY > MAP_SIZE - 1);
-		if (xOut || yOut)
-		{
-			return hit;
-		}
-
-		//Check if ray has hit a wall
-		if (game->gameMap.map[mapY][mapX] > 0)
-		{
-			hit.isHit = TRUE;
-		}
-
-	} // while
-
-	//Calculate distance projected on camera direction ( otherwise oblique distance will give fisheye effect!)
-	if (hit.isSide == TRUE)
-	{
-		perpWallDist = (mapX - mapPos.x + (1 - mapStep.x) / 2) / rayDir.x;
-	}
-	else
-	{
-		perpWallDist = (mapY - mapPos.y + (1 - mapStep.y) / 2) / rayDir.y;
-	}
-
-	// Populate with Hit Data
-	hit.x		= (int)game->player.pos.x;
-	hit.y		= (int)game->player.pos.y;
-	hit.end.x	= (int)rayEndPos.x;
-	hit.end.y	= (int)rayEndPos.y;
-	hit.point.x = mapX;
-	hit.point.y = mapY;
-	hit.dist	= perpWallDist;
-
-	// Calculate where was wall hit on the X Axis
-	double wallX; //where exactly the wall was hit
-	if (hit.isSide == TRUE)
-	{
-		wallX = mapPos.y + perpWallDist * rayDir.y;
-	}
-	else
-	{
-		wallX = mapPos.x + perpWallDist * rayDir.x;
-	}
-	wallX -= floor(wallX);
-
-	// Extend UV Coordinates over N map tiles
-	const int TEX_WIDTH		= game->img_Wall.width;
-	const int SPREAD		= game->gameMap.repeatWall;
-	const double oneOver	= ( 1.0f / SPREAD );
-	double offset			= 0;
-
-	if (hit.isSide == TRUE )
-	{
-		int between		= mapY - ( mapY - (mapY % SPREAD) );
-		offset			= (between / (double)SPREAD);
-	}
-	if (hit.isSide == FALSE )
-	{
-		int between		= mapX - (mapX - (mapX % SPREAD));
-		offset			= (between / (double)SPREAD);
-	}
-	wallX *= oneOver;
-	wallX += offset;
-	
-	// X Coordinate on the Texture based on where wall was hit
-	int texX = (int)( wallX * TEX_WIDTH );
-	if (hit.isSide == TRUE && rayDir.x > 0)
-	{
-		texX = TEX_WIDTH - texX - 1;
-	}
-	if (hit.isSide == FALSE && rayDir.y < 0)
-	{
-		texX = TEX_WIDTH - texX - 1;
-	}
-	hit.texX = texX;
-
-	return hit;
-
-} // Raycast()
-
-void DrawHand( GameState* game )
-{
-	const Vec2 FRAME_PADDING	= { 0.9f, 1.075f }; // for making sure hand is not completly in bottom right corner
-	Anim* handAnim				= &game->player.handAnim;
-	const double BOB_STRENGTH	= ( game->player.isMoving == FALSE ) ? 0 : handAnim->strength;
-	double timeRate				= game->timer.tickCurrent * handAnim->rate;
-	double upAnim				= sin(timeRate) * BOB_STRENGTH;
-	int handSize				= RESOLUTION.x / 2.5f;
-	double handOffsetX			= (RESOLUTION.x * FRAME_PADDING.x) - handSize;
-	double handOffsetY			= (RESOLUTION.y * FRAME_PADDING.y) - handSize - upAnim;
-
-	// Render Hand Overlay
-	SDL_Rect handRect = { (int)handOffsetX, (int)handOffsetY, handSize, handSize };
-	SDL_RenderCopy(game->renderer, game->img_Hand.img, NULL, &handRect );
-
-} // DrawHand()
-
-// Draw one Column to represent world based on Raycast Hit result
-void RenderColumn(GameState *game, Hit *hit, int i )
-{
-	// Calculate Column Height based on distance and resolution
-	int columnHeight		= (int)( RESOLUTION.y / game->gameMap.wallScale / hit->dist );
-	int horizonLine			= (RESOLUTION.y / 2) - (columnHeight / 2);
-	SDL_Rect wallRect		= { i * (int)game->gameMap.columnRatio, horizonLine, (int)game->gameMap.columnRatio, columnHeight };
-
-	// Calculate horizontal UV value ( V is always spans all of texture )
-	const int TEX_SIZE		= game->img_Wall.width - 1;
-	int texU				= (int) ( hit->texX * 0.6667f ); // multiply UV layout to account for perspective distortion
-	texU					= clampI(texU, 1, TEX_SIZE);
-
-	// Create Wall Column
-	if (game->debug.texturedWalls)
-	{
-		SDL_Rect uvRect = { texU, 0, texU, TEX_SIZE };
-		SDL_RenderCopy(game->renderer, game->img_Wall.img, &uvRect, &wallRect);
-	}
-	else
-	{
-		// Render Solid Color
-		SDL_SetRenderDrawColor(game->renderer, 0, 255, 0, 255);
-		SDL_RenderFillRect(game->renderer, &wallRect);
-	}
-
-	// Simple Shadowing
-	if (game->debug.enabledLighting)
-	{
-		// Darken the Columns
-		double darkness		 = (hit->isSide == FALSE) ? hit->dist * (game->gameMap.darknessIntensity/2.0f) : hit->dist * game->gameMap.darknessIntensity;
-		darkness			+= (hit->isSide == FALSE) ? 128 : 0; // side walls are automatically darker
-		Uint8 shadowAlpha	 = clampI( (int)darkness, 0, 255 );
-
-		// Draw Transparent Rect over Column for "shading"
-		SDL_SetRenderDrawColor(game->renderer, 0, 0, 0, shadowAlpha);
-		SDL_RenderFillRect(game->renderer, &wallRect);
-	}
-
-} // RenderColumn()
-
-// Render the Game World in 2.5D 
-void DrawWorld(GameState *game)
-{
-	if ( !game->debug.displayMap )
-	{
-		// Draw Ceiling
-		SDL_SetRenderDrawColor(game->renderer, 0, 0, 05, 255); // Near Black
-		SDL_Rect wallRect = { 0, 0, RESOLUTION.x, RESOLUTION.y }; // Top Half of Screen
-		SDL_RenderFillRect(game->renderer, &wallRect);
-
-		// Draw Floor
-		SDL_Rect floorRect = { 0, RESOLUTION.y / 2, RESOLUTION.x, RESOLUTION.y / 2 }; // Bottom Half of screen
-		SDL_RenderCopy(game->renderer, game->img_Floor.img, NULL, &floorRect);
-	}
-
-	// Raycast and draw the World
-	const int COLUMN_COUNT = (int)RESOLUTION.x * (int)COLUMN_RATIO;
-	int i = 0;
-	for (i = 0; i < COLUMN_COUNT; i++)
-	{
-		Hit hit = Raycast(game, i);
-		if (hit.isHit == TRUE)
-		{
-			if (game->debug.drawRays) // Debug Draw Rays
-			{
-				SDL_SetRenderDrawColor(game->renderer, 255, 0, 0, SDL_ALPHA_OPAQUE);
-				SDL_RenderDrawLine(game->renderer, hit.x, hit.y, hit.end.x, hit.end.y );
-
-				// Draw Hit Point Rects TODO: put in own function
-				SDL_Rect hitRect = { hit.point.x * GRID_RES.x, hit.point.y * GRID_RES.y, GRID_RES.x, GRID_RES.y };
-				if (hit.isSide == TRUE)
-				{
-					SDL_SetRenderDrawColor(game->renderer, 255, 255, 128, SDL_ALPHA_OPAQUE);
-				}
-				else
-				{
-					SDL_SetRenderDrawColor(game->renderer, 128, 255, 255, SDL_ALPHA_OPAQUE);
-				}
-				SDL_RenderFillRect(game->renderer, &hitRect);
-
-				if (game->debug.displayMap)
-				{
-					continue;
-				}
-			}
-			RenderColumn(game, &hit, i);
-		}
-
-	} // for
-
-} // DrawWorld()
-
-void DoRender( GameState *game )
-{
-	// Clear Screen
-	SDL_SetRenderDrawColor( game->renderer, 0, 0, 255, 255);
-	SDL_RenderClear(game->renderer);
-
-	if ( game->debug.displayMap ) // / Debug Draw Topdown 2D Map
-	{ 	
-		DrawMap(game);
-		DebugDrawPlayer(game);
-		if (game->debug.drawRays)
-		{
-			DrawWorld(game);
-		}
-	}
-	else // Render 2.5D World
-	{
-		DrawWorld(game);
-		DrawHand(game);
-	}
-
-	// Flag Ready to Render
-	SDL_RenderPresent(game->renderer);
-
-} // DoRender()
-
-void LoadImage( SDL_Renderer* renderer, const char* imgPath, Image* imageTo )
-{
-	SDL_Surface* imgSurface = NULL;
-	imgSurface = IMG_Load(imgPath);
-	if ( imgSurface == NULL)
-	{
-		printf("Cannot find: %s \n\n", imgPath );
-		SDL_Quit();
-		exit(1);
-	}
-
-	imageTo->img = SDL_CreateTextureFromSurface( renderer, imgSurface );
-	SDL_FreeSurface( imgSurface );
-	SDL_QueryTexture( imageTo->img, NULL, NULL, &imageTo->width, &imageTo->height );
-
-} // LoadImage()
-
-void GetResources( GameState* game )
-{
-	LoadImage(game->renderer, CHECKER_PATH,		&game->img_Checker );
-	LoadImage(game->renderer, WALL_PATH,		&game->img_Wall );
-	LoadImage(game->renderer, FLOOR_PATH,		&game->img_Floor );
-	LoadImage(game->renderer, HAND_PATH,		&game->img_Hand );
-
-} // GetResources()
-
-void LoadGame( GameState* game )
-{
-	// Seed the pseudo-random number generator
-	srand((int)time(NULL)); 
-
-	// Load all textures etc needed for game
-	GetResources( game );
-
-	// Player Setup
-	InitializePlayer( &game->player );
-
-	// Setup GameMap
-	InitializeMap(&game->gameMap, RAY_LENGTH, COLUMN_RATIO, WALL_SCALE, DARKNESS_INTENSITY, REPEAT_WALL );
-
-} // LoadGame()
-
-// Write out Debug Benchmark Info to File
-void DebugOutput(const char* outputText)
-{
-	// Debug Output To File Setup
-	SDL_RWops* debugFile = SDL_RWFromFile(DEBUG_PATH, "a+");
-	if (debugFile == NULL)
-	{
-		printf("Warning: Unable to open file! SDL Error: %s\n", SDL_GetError());
-		printf("New file created!\n");
-		debugFile = SDL_RWFromFile(DEBUG_PATH, "+");
-	}
-	if (debugFile != NULL)
-	{
-		printf("Writing to File! \n");
-		size_t len = SDL_strlen(outputText);
-		SDL_RWwrite(debugFile, outputText, 1, len);
-
-		//Close file handler 
-		SDL_RWclose(debugFile);
-	}
-
-} // DebugOutput()
-
-void UpdateTime( Timer* timer )
-{
-	// Delta Time
-	timer->perfPrevious		= timer->perfCurrent;
-	timer->perfCurrent		= SDL_GetPerformanceCounter();
-	timer->deltaTime		= (timer->perfCurrent - timer->perfPrevious) / (double)SDL_GetPerformanceFrequency();
-
-	// Frame Rate
-	timer->tickPrevious		= timer->tickCurrent;
-	timer->tickCurrent		= SDL_GetTicks();
-	timer->frameRate		= 1000.0f / (timer->tickCurrent - timer->tickPrevious );
-
-	printf("DT: %f \n", timer->deltaTime);
-	printf("FPS: %d \n", (int)timer->frameRate);
-
-} // UpdateTime()
-
-int Benchmark()
-{
-#if BENCHMARK
-	double timeInSeconds	= (int)clock() / CLOCKS_PER_SEC;
-
-	if (timeInSeconds >= 5 )
-	{
-		char* output = malloc(16);
-		snprintf(output, 16, "\n Timing: %d", SDL_GetTicks() );
-		DebugOutput(output);
-		return TRUE;
-	}
-	return FALSE;
-#else
-	return FALSE;
-#endif
-
-} // Benchmark()
-
-
-int ExitGame( GameState* game )
-{
-	// Deallocate Resources
-	SDL_DestroyTexture(game->img_Checker.img);
-	SDL_DestroyTexture(game->img_Wall.img);
-	SDL_DestroyTexture(game->img_Floor.img);
-	SDL_DestroyTexture(game->img_Hand.img);
-
-	SDL_DestroyWindow(game->window);
-	SDL_DestroyRenderer(game->renderer);
-	SDL_Quit();
-
-	return 0;
-
-} // ExitGame()
-
-void SetupGameState( GameState *game )
-{
-	memset( game, 0, sizeof *game );
-	game->window			= NULL;
-	game->renderer			= NULL;
-	game->debug				= (Debug) { FALSE, TRUE, FALSE, FALSE, TRUE };
-
-} // SetupGameState()
-
-int main(int argc, char *argv[])
-{
-	GameState game;
-	SetupGameState(&game);
-
-	// Setup Video
-	SDL_Init(SDL_INIT_VIDEO);
-	game.window = SDL_CreateWindow("RaycastEngine", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, RESOLUTION.x, RESOLUTION.y, 0);
-	game.renderer = SDL_CreateRenderer(game.window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
-	SDL_SetRenderDrawBlendMode(game.renderer, SDL_BLENDMODE_BLEND);
-	SDL_ShowCursor(SDL_DISABLE);
-
-	LoadGame(&game);
-
-	// Main Game Loop
-	int done = 0;
-	while ( !done )
-	{
-		UpdateTime(&game.timer);
-		done = ProcessInputsAndEvents( &game );
-		DoRender( &game );
-		done += Benchmark();
-	} // while
-
-	// Exit Game, Unload All Memory
-	return ExitGame( &game );
-
+#pragma once 
+
+#include <time.h>
+#include <stdlib.h>
+#include "SDL.h"
+#include "SDL_image.h"
+#include "Player.h"
+#include "Framebuffer.h"
+#include "RayTraversal.h"
+#include "RayPacket.h"
+#include "ThreadPool.h"
+#include "WallFaces.h"
+#include "ColumnRays.h"
+#include "Colormap.h"
+#include "FloorCasting.h"
+#include "ViewLabels.h"
+#include "GameState.h"
+#include "VecEnv.h"
+
+#define BENCHMARK			0
+
+// Environment Values
+#define	RAY_LENGTH			100
+#define	COLUMN_RATIO		1
+#define	WALL_SCALE			0.4f
+#define	DARKNESS_INTENSITY	15
+#define	REPEAT_WALL			2
+
+// Rendering Values
+#define SOFTWARE_RENDER		1 // draw the 3D view into a CPU Framebuffer instead of per-column renderer calls
+#define CEILING_COLOR		0, 0, 5
+#define TRAVERSAL			TRAVERSAL_PACKET // default way rays walk the map, see RayTraversal.h
+#define WORKER_THREADS		0 // threads casting columns, 0 = one per CPU core
+#define COLUMN_CHUNK		32 // columns per work item, multiple of RAY_PACKET_SIZE
+#define COALESCE_FACES		1 // draw runs of columns on the same wall face as one trapezoid
+#define FRAME_CACHE			1 // reuse the last frame's Hits and pixels while the view is unchanged
+#define ADAPTIVE_COLUMNS	1 // cast rays at a coarse stride, refining only where neighbouring Hits disagree
+#define ADAPTIVE_STRIDE		16 // columns between the coarse rays
+#define MAX_DIST_JUMP		1.0 // neighbouring Hits further apart than this fraction of the nearer dist are refined
+#define FAR_PLANE			1 // rays stop after RAY_LENGTH cells, their columns are filled with FOG_COLOR
+#define FOG_COLOR			10, 10, 14
+#define MIPMAP_WALLS		1 // sample walls from the mip level that fits their projected column height
+#define MIN_MIP_SIZE		2 // smallest mip level dimension, in texels
+#define FLOOR_CASTING		1 // perspective correct textured floor and ceiling instead of a flat ceiling and stretched floor
+#define CEILING_DARKNESS	128 // added to the darkness of the floor row a ceiling row mirrors
+#define SPAN_COMPOSITION	1 // draw the walls first, then ceiling and floor only around them, so every pixel is written once
+#define PARALLEL_RASTER		1 // rasterize vertical strips of the Framebuffer on the worker threads
+#define RASTER_STRIP		32 // pixel columns per strip, a multiple of the pixels in a cache line
+#define DYNAMIC_RESOLUTION	1 // lower the internal resolution of the Framebuffer path while the 3D view costs more than RENDER_BUDGET_MS
+#define RENDER_BUDGET_MS	10.0 // CPU time per frame for casting and rasterizing, the rest of the frame is presenting and vsync
+#define MIN_RENDER_SCALE	0.5 // lowest internal resolution, per axis, as a fraction of the window
+#define RENDER_SCALE_STEP	0.05 // largest change of the render scale per frame
+#define UPSCALE_FILTER		"linear" // SDL_HINT_RENDER_SCALE_QUALITY of the Framebuffer textures, "nearest" keeps hard pixels
+
+// Headless Values, see RunHeadless()
+#define HEADLESS_FRAMES		600 // frames a --headless run renders when no count is given
+#define HEADLESS_STEP		( 1.0 / 60 ) // simulated seconds per headless frame, the walk does not depend on how fast frames render
+#define HEADLESS_CHECKSUMS	"Resources/headless_checksums.txt" // default checksum file, "--checksums none" writes none
+#define VERIFY_THREADS		4 // fewest workers of a --verify-threads run, which also renders every frame on one thread
+#define BATCH_OUTPUT		"Resources/batch_frames.raw" // default stream of a --batch run
+#define BATCH_CHUNK			4 // poses a batch worker takes at a time
+#define ENV_WIDTH			160 // observation size of an --env run without --size
+#define ENV_HEIGHT			120
+#define ENV_STEPS			1000 // steps of an --env run when no count is given
+
+// Command line of a headless run, see ParseHeadlessOptions()
+typedef struct
+{
+	int			frameCount;
+	VecI2		size; // 0 x 0 uses the default size of the kind of run, see HeadlessSize()
+	const char*	checksumPath; // a line per frame with its checksum, NULL writes none
+	const char*	framePath; // prefix of the numbered PPM file of every frame, NULL writes none
+	int			verifyThreads; // render every frame on one thread too, and fail on a checksum that differs
+	const char*	posePath; // pose file of a batch run, NULL for the scripted walk
+	const char*	outputPath; // raw frame stream of a batch run
+	int			envCount; // instances of an environment run, 0 for none
+	int			envSteps;
+	int			envObserve; // OBSERVE_ bits of an environment run
+	int			benchTraversals; // time every traversal on the loaded map, see RunDiagnostics()
+	int			runChecks; // self-checks, the run fails on any mismatch
+
+} HeadlessOptions;
+
+// Camera of one batch frame
+typedef struct
+{
+	Vec2	pos; // in map cells
+	Vec2	direction;
+	double	fov; // horizontal, in degrees
+
+} Pose;
+
+// One batch worker: its renderer context, a frame of packed RGB and its own handle on the output stream
+typedef struct
+{
+	GameState	view;
+	Uint8*		packed;
+	SDL_RWops*	output;
+
+} BatchWorker;
+
+typedef struct
+{
+	Pose*			poses;
+	int				poseCount;
+	size_t			frameBytes;
+	BatchWorker*	workers; // indexed by thread pool worker
+	SDL_atomic_t	failures; // frames that could not be written
+
+} BatchRender;
+
+void EnableFullscreen( SDL_Window* window, Debug* debug )
+{
+	// Desktop fullscreen keeps the display's own mode, the view follows through the resulting size change event
+	if ( debug->isFullscreen != SDL_WINDOW_FULLSCREEN_DESKTOP)
+	{
+		debug->isFullscreen = SDL_WINDOW_FULLSCREEN_DESKTOP;
+		SDL_SetWindowFullscreen( window, SDL_WINDOW_FULLSCREEN_DESKTOP);
+	}
+
+} // EnableFullscreen()
+
+void DisableFullscreen( SDL_Window* window, Debug* debug )
+{
+	if ( debug->isFullscreen != 0 )
+	{
+		debug->isFullscreen = 0;
+		SDL_SetWindowFullscreen( window, 0);
+	}
+
+} // DisableFullscreen()
+
+void ProcessDebugInput( const Uint8* state, Uint8* statePrev, SDL_Window* window, Debug* debug )
+{
+	// Toggle Debug Displays
+	if ( state[SDL_SCANCODE_1] )
+	{
+		debug->texturedWalls = TRUE;
+	}
+	if (state[SDL_SCANCODE_2])
+	{
+		debug->texturedWalls = FALSE;
+	}
+	if (state[SDL_SCANCODE_3])
+	{
+		debug->enabledLighting = FALSE;
+	}
+	if (state[SDL_SCANCODE_4])
+	{
+		debug->enabledLighting = TRUE;
+	}
+	if (state[SDL_SCANCODE_5])
+	{
+		debug->softwareRender = TRUE;
+	}
+	if (state[SDL_SCANCODE_6])
+	{
+		debug->softwareRender = FALSE;
+	}
+	if (state[SDL_SCANCODE_7])
+	{
+		debug->coalesceFaces = TRUE;
+	}
+	if (state[SDL_SCANCODE_8])
+	{
+		debug->coalesceFaces = FALSE;
+	}
+	if (state[SDL_SCANCODE_F1])
+	{
+		debug->frameCache = TRUE;
+	}
+	if (state[SDL_SCANCODE_F2])
+	{
+		debug->frameCache = FALSE;
+	}
+	if (state[SDL_SCANCODE_F10])
+	{
+		debug->adaptiveColumns = TRUE;
+	}
+	if (state[SDL_SCANCODE_F11])
+	{
+		debug->adaptiveColumns = FALSE;
+	}
+	if (state[SDL_SCANCODE_O])
+	{
+		debug->farPlane = TRUE;
+	}
+	if (state[SDL_SCANCODE_P])
+	{
+		debug->farPlane = FALSE;
+	}
+	if (state[SDL_SCANCODE_U])
+	{
+		debug->mipmaps = TRUE;
+	}
+	if (state[SDL_SCANCODE_I])
+	{
+		debug->mipmaps = FALSE;
+	}
+	if (state[SDL_SCANCODE_J])
+	{
+		debug->floorCasting = TRUE;
+	}
+	if (state[SDL_SCANCODE_K])
+	{
+		debug->floorCasting = FALSE;
+	}
+	if (state[SDL_SCANCODE_T])
+	{
+		debug->spanComposition = TRUE;
+	}
+	if (state[SDL_SCANCODE_Y])
+	{
+		debug->spanComposition = FALSE;
+	}
+	if (state[SDL_SCANCODE_G])
+	{
+		debug->parallelRaster = TRUE;
+	}
+	if (state[SDL_SCANCODE_H])
+	{
+		debug->parallelRaster = FALSE;
+	}
+	if (state[SDL_SCANCODE_Z])
+	{
+		debug->dynamicResolution = TRUE;
+	}
+	if (state[SDL_SCANCODE_X])
+	{
+		debug->dynamicResolution = FALSE;
+	}
+	if (state[SDL_SCANCODE_9])
+	{
+		debug->drawRays = FALSE;
+	}
+	if (state[SDL_SCANCODE_0])
+	{
+		debug->drawRays = TRUE;
+	}
+	if (state[SDL_SCANCODE_M])
+	{
+		debug->displayMap	= TRUE;
+		debug->drawRays		= TRUE;
+	}
+	if (state[SDL_SCANCODE_N])
+	{
+		debug->displayMap	= FALSE;
+		debug->drawRays		= FALSE;
+	}
+	if (state[SDL_SCANCODE_F5])
+	{
+		debug->traversal = TRAVERSAL_SCALAR;
+	}
+	if (state[SDL_SCANCODE_F6])
+	{
+		debug->traversal = TRAVERSAL_PACKET;
+	}
+	if (state[SDL_SCANCODE_F7])
+	{
+		debug->traversal = TRAVERSAL_OCCUPANCY;
+	}
+	if (state[SDL_SCANCODE_F8])
+	{
+		debug->traversal = TRAVERSAL_DISTANCE;
+	}
+	if (state[SDL_SCANCODE_F9])
+	{
+		debug->traversal = TRAVERSAL_SWEEP;
+	}
+	if (state[SDL_SCANCODE_F3])
+	{
+		DisableFullscreen( window, debug );
+	}
+	if (state[SDL_SCANCODE_F4])
+	{
+		EnableFullscreen(window, debug);
+	}
+
+} // ProcessDebugInput()
+
+void FreeViewBuffers( GameState* game )
+{
+	DestroyFramebuffer( &game->frameBuffer );
+	DestroyFramebuffer( &game->wallLayer );
+	FreeColumnRays( &game->columnRays );
+	free( game->columnHits );
+	free( game->faceRuns );
+	_mm_free( game->wallSpans );
+	game->columnHits	= NULL;
+	game->faceRuns		= NULL;
+	game->wallSpans		= NULL;
+
+} // FreeViewBuffers()
+
+// Framebuffers and per column tables for a view of size, RESOLUTION for the window. Built at load and rebuilt by ResizeView() only
+int AllocateViewBuffers( GameState* game, VecI2 size )
+{
+	FreeViewBuffers( game );
+	const int COLUMNS	= size.x * COLUMN_RATIO;
+	game->columnHits	= malloc( sizeof(Hit) * COLUMNS );
+	game->faceRuns		= malloc( sizeof(FaceRun) * COLUMNS );
+	game->wallSpans		= _mm_malloc( sizeof(WallSpan) * size.x, CACHE_LINE ); // strips of whole cache lines never share one
+
+	SDL_SetHint( SDL_HINT_RENDER_SCALE_QUALITY, UPSCALE_FILTER ); // only the Framebuffer textures created below are upscaled
+	if ( game->columnHits == NULL || game->faceRuns == NULL || game->wallSpans == NULL || !BuildColumnRays( &game->columnRays, COLUMNS ) ||
+		 !AllocateSweepColumns( &game->wallSweep, COLUMNS ) ||
+		 !CreateFramebuffer( game->renderer, &game->frameBuffer, size.x, size.y ) || !CreateFramebuffer( game->renderer, &game->wallLayer, size.x, size.y ) )
+	{
+		printf("Cannot allocate the view for %dx%d \n\n", size.x, size.y );
+		return FALSE;
+	}
+	if ( game->wallLayer.texture != NULL )
+	{
+		SDL_SetTextureBlendMode( game->wallLayer.texture, SDL_BLENDMODE_BLEND );
+	}
+	return TRUE;
+
+} // AllocateViewBuffers()
+
+// Adopt a new output size, once per change: every table derived from it is rebuilt here so frames pay nothing for it
+void ResizeView( GameState* game, int width, int height )
+{
+	if ( width <= 0 || height <= 0 || ( width == RESOLUTION.x && height == RESOLUTION.y ) )
+	{
+		return;
+	}
+
+	RESOLUTION = (VecI2) { width, height };
+	if ( !AllocateViewBuffers( game, RESOLUTION ) )
+	{
+		SDL_Quit();
+		exit(1);
+	}
+	game->renderCost = 0; // was measured against the old size
+	memset( &game->frameKey, 0, sizeof(game->frameKey) ); // nothing drawn before survives
+
+} // ResizeView()
+
+// A second renderer context over game's loaded map, textures and colormap, which it only reads. It gets its own Player,
+// view buffers of size and wall sweep, but no renderer and no thread pool, so it rasterizes on whichever thread uses it
+int CreateViewContext( GameState* view, const GameState* game, VecI2 size )
+{
+	*view				= *game;
+	view->window		= NULL;
+	view->renderer		= NULL;
+	view->statePrev		= NULL;
+	view->columnHits	= NULL;
+	view->faceRuns		= NULL;
+	view->wallSpans		= NULL;
+	view->isStaticFrame	= FALSE;
+	memset( &view->frameBuffer, 0, sizeof(view->frameBuffer) );
+	memset( &view->wallLayer, 0, sizeof(view->wallLayer) );
+	memset( &view->columnRays, 0, sizeof(view->columnRays) );
+	memset( &view->wallSweep, 0, sizeof(view->wallSweep) );
+	memset( &view->threadPool, 0, sizeof(view->threadPool) );
+	return AllocateViewBuffers( view, size );
+
+} // CreateViewContext()
+
+void DestroyViewContext( GameState* view )
+{
+	FreeViewBuffers( view );
+	FreeWallSweep( &view->wallSweep );
+
+} // DestroyViewContext()
+
+// isResized is set when the window's size changed, by the user or by toggling fullscreen
+int ProcessWindowEvents(SDL_Window* window, int* isResized)
+{
+	int done = FALSE;
+	SDL_Event event;
+
+	// Check for events
+	while ( SDL_PollEvent(&event) )
+	{
+		switch (event.type)
+		{
+		case SDL_WINDOWEVENT_CLOSE:
+		{
+			if (window)
+			{
+				SDL_DestroyWindow(window);
+				window	= NULL;
+				done	= TRUE;
+			}
+		}
+		break;
+		case SDL_WINDOWEVENT:
+		{
+			if (event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED)
+			{
+				*isResized = TRUE;
+			}
+		}
+		break;
+		case SDL_KEYDOWN:
+		{
+			switch (event.key.keysym.sym)
+			{
+			case SDLK_ESCAPE:
+				done = TRUE;
+				break;
+			}
+		}
+		break;
+		case SDL_QUIT:
+			done = TRUE;
+			break;
+		}
+	}
+	return done;
+
+} // ProcessWindowEvents()
+
+int ProcessInputsAndEvents( GameState *game )
+{
+	int isResized	= FALSE;
+	int done		= ProcessWindowEvents(game->window, &isResized);
+	if (isResized)
+	{
+		// Any number of size changes since the last frame are handled with one rebuild
+		int width, height;
+		SDL_GetRendererOutputSize(game->renderer, &width, &height);
+		ResizeView(game, width, height);
+	}
+
+	const Uint8* state = SDL_GetKeyboardState(NULL);
+	ProcessDebugInput(state, game->statePrev, game->window, &game->debug );
+	ProcessPlayerInput( state, &game->player, &game->gameMap, game->timer.deltaTime );
+
+	return done;
+
+} // ProcessInputsAndEvents()
+
+// Top-left of the 2D Map view in world units, follows the Player on maps bigger than the screen
+VecI2 GetMapViewOffset(GameState *game)
+{
+	const int WORLD_WIDTH	= game->gameMap.width * GRID_RES.x;
+	const int WORLD_HEIGHT	= game->gameMap.height * GRID_RES.y;
+	int x = clampI( (int)game->player.pos.x - RESOLUTION.x / 2, 0, max(WORLD_WIDTH - RESOLUTION.x, 0) );
+	int y = clampI( (int)game->player.pos.y - RESOLUTION.y / 2, 0, max(WORLD_HEIGHT - RESOLUTION.y, 0) );
+	return vecI2( x, y );
+
+} // GetMapViewOffset()
+
+// Debug Displaying 2D Map
+void DrawMap(GameState *game)
+{
+	// Only the cells that are on screen
+	VecI2 view		= GetMapViewOffset(game);
+	int firstRow	= view.y / GRID_RES.y;
+	int firstColumn	= view.x / GRID_RES.x;
+	int lastRow		= min( (view.y + RESOLUTION.y) / GRID_RES.y, game->gameMap.height - 1 );
+	int lastColumn	= min( (view.x + RESOLUTION.x) / GRID_RES.x, game->gameMap.width - 1 );
+
+	for (int i = firstRow; i <= lastRow; i++) // Rows
+	{
+		for (int j = firstColumn; j <= lastColumn; j++) // Columns
+		{
+			if ( GetTile(&game->gameMap, j, i) == FALSE)
+			{
+				continue;
+			}
+			SDL_Rect tileRect = { j * GRID_RES.x - view.x, i * GRID_RES.y - view.y, GRID_RES.x, GRID_RES.y };
+			SDL_RenderCopy(game->renderer, game->img_Checker.img, NULL, &tileRect);
+		} // for
+
+	} // for
+
+} // DrawMap()
+
+  // Draw Player on 2D Map ( including camera facing )
+void DebugDrawPlayer(GameState *game)
+{
+	// Debug Draw Player Dir
+	const float DIR_LENGTH = RESOLUTION.x / 10.0f;
+	VecI2 view = GetMapViewOffset(game);
+	Vec2 playerPos = { game->player.pos.x - view.x, game->player.pos.y - view.y };
+	Vec2 endPos = GetProjectedVector(&playerPos, &game->player.direction, -DIR_LENGTH);
+	SDL_SetRenderDrawColor(game->renderer, 255, 255, 0, SDL_ALPHA_OPAQUE);
+	SDL_RenderDrawLine(game->renderer, (int)playerPos.x, (int)playerPos.y, (int)endPos.x, (int)endPos.y);
+
+	// Debug Draw Camera Plane
+	Vec2 camStart = GetProjectedVector(&endPos, &game->player.cameraPlane, -DIR_LENGTH);
+	Vec2 camEnd = GetProjectedVector(&endPos, &game->player.cameraPlane, DIR_LENGTH);
+	SDL_SetRenderDrawColor(game->renderer, 0, 255, 255, SDL_ALPHA_OPAQUE);
+	SDL_RenderDrawLine(game->renderer, (int)camStart.x, (int)camStart.y, (int)camEnd.x, (int)camEnd.y);
+
+	// Draw Player Pos
+	SDL_SetRenderDrawColor(game->renderer, 0, 255, 0, 255);
+	double sizeHalf = game->player.debugSize / 2.0f;
+	SDL_Rect rect = { (int)(playerPos.x - sizeHalf), (int)(playerPos.y - sizeHalf), game->player.debugSize, game->player.debugSize };
+	SDL_RenderFillRect(game->renderer, &rect);
+
+} // DebugDrawPlayerDir()
+
+// Unrounded texel column a wall was hit at, before mirroring for the side it was seen from
+double WallTexCoord(GameState *game, int isSide, Vec2 rayDir, Vec2 mapPos, int mapX, int mapY, double perpWallDist)
+{
+	// Calculate where was wall hit on the X Axis
+	double wallX; //where exactly the wall was hit
+	if (isSide == TRUE)
+	{
+		wallX = mapPos.y + perpWallDist * rayDir.y;
+	}
+	else
+	{
+		wallX = mapPos.x + perpWallDist * rayDir.x;
+	}
+	wallX -= floor(wallX);
+
+	// Extend UV Coordinates over N map tiles
+	const int TEX_WIDTH		= game->img_Wall.width;
+	const int SPREAD		= game->gameMap.repeatWall;
+	const double oneOver	= ( 1.0f / SPREAD );
+	double offset			= 0;
+
+	if (isSide == TRUE )
+	{
+		int between		= mapY - ( mapY - (mapY % SPREAD) );
+		offset			= (between / (double)SPREAD);
+	}
+	if (isSide == FALSE )
+	{
+		int between		= mapX - (mapX - (mapX % SPREAD));
+		offset			= (between / (double)SPREAD);
+	}
+	wallX *= oneOver;
+	wallX += offset;
+	return wallX * TEX_WIDTH;
+
+} // WallTexCoord()
+
+// Texture column for a texel coordinate, mirrored so the texture reads the same way from both sides of a wall
+int MirrorTexX(GameState *game, int isSide, Vec2 rayDir, double texCoord)
+{
+	const int TEX_WIDTH = game->img_Wall.width;
+	int texX = (int)texCoord;
+	if (isSide == TRUE && rayDir.x > 0)
+	{
+		texX = TEX_WIDTH - texX - 1;
+	}
+	if (isSide == FALSE && rayDir.y < 0)
+	{
+		texX = TEX_WIDTH - texX - 1;
+	}
+	return texX;
+
+} // MirrorTexX()
+
+// Fill in distance and texture data of a Hit once the DDA has found a wall
+void ResolveHit(GameState *game, Hit *hit, Vec2 rayDir, Vec2 mapPos, VecI2 mapStep, int mapX, int mapY, Vec2 rayEndPos)
+{
+	double perpWallDist;
+
+	//Calculate distance projected on camera direction ( otherwise oblique distance will give fisheye effect!)
+	//In double whatever RAY_SCALAR is: one division per hit, and dist and texX are exact whenever the traversal found the right cell and side
+	if (hit->isSide == TRUE)
+	{
+		perpWallDist = (mapX - mapPos.x + (1 - mapStep.x) / 2) / rayDir.x;
+	}
+	else
+	{
+		perpWallDist = (mapY - mapPos.y + (1 - mapStep.y) / 2) / rayDir.y;
+	}
+
+	// Populate with Hit Data
+	hit->x		= (int)game->player.pos.x;
+	hit->y		= (int)game->player.pos.y;
+	hit->end.x	= (int)rayEndPos.x;
+	hit->end.y	= (int)rayEndPos.y;
+	hit->point.x = mapX;
+	hit->point.y = mapY;
+	hit->dist	= perpWallDist;
+
+	// X Coordinate on the Texture based on where wall was hit
+	hit->texX	= MirrorTexX(game, hit->isSide, rayDir, WallTexCoord(game, hit->isSide, rayDir, mapPos, mapX, mapY, hit->dist));
+
+	// Walls whose perpendicular distance rounds past the far plane are fogged too
+	if (game->debug.farPlane && hit->dist > game->gameMap.rayLength)
+	{
+		hit->isHit = FALSE;
+		hit->isFog = TRUE;
+	}
+
+} // ResolveHit()
+
+Hit Raycast(GameState *game, int column)
+{
+	// Initialize Hit ( Default )
+	Hit hit;
+	memset(&hit, 0, sizeof(hit) );
+
+	// Calculate Ray Position and Direction
+	Vec2 rayDir			= ColumnRayDir(&game->columnRays, column);
+
+	//which box of the map we're in
+	Vec2 mapPos = { game->player.pos.x / GRID_RES.x, game->player.pos.y / GRID_RES.y };
+
+	RayState ray;
+	InitRayStateDelta(&ray, mapPos, rayDir, ColumnDeltaDist(&game->columnRays, column));
+	if (game->debug.farPlane)
+	{
+		SetRayFarPlane(&ray, game->gameMap.rayLength, game->columnRays.dirLength[column]);
+	}
+
+	//perform DDA
+	int status = WalkRay(&ray, &game->gameMap, game->debug.traversal, NULL);
+
+	hit.isSide = ray.isSide;
+	hit.isFog = (status == RAY_PAST_FAR);
+	if (status != RAY_HIT)
+	{
+		return hit;
+	}
+
+	hit.isHit = TRUE;
+	ResolveHit(game, &hit, rayDir, mapPos, ray.mapStep, ray.mapX, ray.mapY, RayEndPos(game->player.pos, ray.steps, ray.mapStep));
+	return hit;
+
+} // Raycast()
+
+// Raycast up to RAY_PACKET_SIZE columns at once into game->columnHits, same Hits as calling Raycast() for each
+void RaycastPacket(GameState *game, const int *columns, int count)
+{
+	RayPacket packet;
+	packet.startPos	= game->player.pos;
+	packet.mapPos	= vec2( game->player.pos.x / GRID_RES.x, game->player.pos.y / GRID_RES.y );
+
+	const ColumnRays* rays = &game->columnRays;
+	for (int lane = 0; lane < RAY_PACKET_SIZE; lane++)
+	{
+		int i						= columns[min(lane, count - 1)];
+		packet.rayDirX[lane]		= rays->rayDirX[i];
+		packet.rayDirY[lane]		= rays->rayDirY[i];
+		packet.deltaDistX[lane]		= rays->deltaDistX[i];
+		packet.deltaDistY[lane]		= rays->deltaDistY[i];
+		packet.farDist[lane]		= game->debug.farPlane ? game->gameMap.rayLength * rays->dirLength[i] : INFINITY;
+	}
+
+	TraversePacket(&game->gameMap, &packet, count);
+
+	for (int lane = 0; lane < count; lane++)
+	{
+		Hit* hit = &game->columnHits[columns[lane]];
+		memset(hit, 0, sizeof(*hit) );
+		hit->isSide = packet.isSide[lane];
+		hit->isFog	= packet.isFar[lane];
+		if (packet.isHit[lane] == FALSE)
+		{
+			continue; // left the map or reached the far plane
+		}
+
+		hit->isHit = TRUE;
+		ResolveHit(game, hit, vec2(packet.rayDirX[lane], packet.rayDirY[lane]), packet.mapPos, packet.mapStep[lane],
+			packet.mapX[lane], packet.mapY[lane], RayEndPos(packet.startPos, packet.steps[lane], packet.mapStep[lane]));
+	}
+
+} // RaycastPacket()
+
+// Hit of a ray already known to end on the given side of a wall cell, without walking it
+void ResolveFaceHit(GameState *game, Hit *hit, Vec2 rayDir, Vec2 mapPos, int mapX, int mapY, int isSide)
+{
+	// Same crossings the DDA would have taken to reach the cell
+	VecI2 mapStep	= { (rayDir.x < 0) ? -1 : 1, (rayDir.y < 0) ? -1 : 1 };
+	VecI2 steps		= { abs(mapX - (int)mapPos.x), abs(mapY - (int)mapPos.y) };
+	memset(hit, 0, sizeof(*hit) );
+	hit->isHit		= TRUE;
+	hit->isSide		= isSide;
+	ResolveHit(game, hit, rayDir, mapPos, mapStep, mapX, mapY, RayEndPos(game->player.pos, steps, mapStep));
+
+} // ResolveFaceHit()
+
+// Every ray between columns a and b ends on the same face as both of them when they hit the same side of the
+// same cell, and the wedge between them is narrower than a cell up to that face so no wall fits inside it
+int CanInterpolateColumns(GameState *game, int a, int b)
+{
+	Hit* hitA = &game->columnHits[a];
+	Hit* hitB = &game->columnHits[b];
+	if (!hitA->isHit || !hitB->isHit || hitA->isSide != hitB->isSide || hitA->point.x != hitB->point.x || hitA->point.y != hitB->point.y)
+	{
+		return FALSE;
+	}
+	if (fabs(hitA->dist - hitB->dist) > MAX_DIST_JUMP * min(hitA->dist, hitB->dist))
+	{
+		return FALSE;
+	}
+
+	const double COLUMN_TOTAL	= game->columnRays.columnCount;
+	const double PLANE_LENGTH	= sqrt(square(game->player.cameraPlane.x) + square(game->player.cameraPlane.y));
+	double wedgeWidth			= max(hitA->dist, hitB->dist) * PLANE_LENGTH * 2 * (b - a) / COLUMN_TOTAL;
+	return wedgeWidth < 1.0;
+
+} // CanInterpolateColumns()
+
+// Fill the columns strictly between a and b ( both cast ), returns the rays it cast
+int RefineColumns(GameState *game, int a, int b)
+{
+	if (b - a <= 1)
+	{
+		return 0;
+	}
+
+	if (CanInterpolateColumns(game, a, b))
+	{
+		Hit* face	= &game->columnHits[a];
+		Vec2 mapPos	= { game->player.pos.x / GRID_RES.x, game->player.pos.y / GRID_RES.y };
+		for (int i = a + 1; i < b; i++)
+		{
+			Vec2 rayDir = ColumnRayDir(&game->columnRays, i);
+			ResolveFaceHit(game, &game->columnHits[i], rayDir, mapPos, face->point.x, face->point.y, face->isSide);
+		}
+		return 0;
+	}
+
+	int middle					= (a + b) / 2;
+	game->columnHits[middle]	= Raycast(game, middle);
+	return 1 + RefineColumns(game, a, middle) + RefineColumns(game, middle, b);
+
+} // RefineColumns()
+
+// Fixed point has no packet kernel, its columns are walked one by one
+int IsPacketTraversal(GameState *game)
+{
+	return game->debug.traversal == TRAVERSAL_PACKET && IS_PACKET_EXACT;
+
+} // IsPacketTraversal()
+
+// Columns [start, end) from rays every ADAPTIVE_STRIDE columns, refined where their Hits disagree
+void CastAdaptiveRange(GameState *game, int start, int end)
+{
+	// Coarse columns first, a packet of them at a time with the packet traversal
+	const int PACKET_SIZE	= IsPacketTraversal(game) ? RAY_PACKET_SIZE : 1;
+	int columns[RAY_PACKET_SIZE];
+	int count				= 0;
+	int rays				= 0;
+	for (int column = start; ; column = min(column + ADAPTIVE_STRIDE, end - 1))
+	{
+		columns[count++] = column;
+		if (count == PACKET_SIZE || column == end - 1)
+		{
+			if (PACKET_SIZE > 1)
+			{
+				RaycastPacket(game, columns, count);
+			}
+			else
+			{
+				game->columnHits[column] = Raycast(game, column);
+			}
+			rays	+= count;
+			count	= 0;
+		}
+		if (column == end - 1)
+		{
+			break;
+		}
+	}
+
+	for (int a = start, b; a < end - 1; a = b)
+	{
+		b		= min(a + ADAPTIVE_STRIDE, end - 1);
+		rays	+= RefineColumns(game, a, b);
+	}
+	SDL_AtomicAdd(&game->rayCount, rays);
+
+} // CastAdaptiveRange()
+
+// Worker job, columns [start, end) of the frame into game->columnHits
+void CastColumnRange(void *context, int start, int end, int worker)
+{
+	GameState* game = (GameState*)context;
+	if (game->debug.adaptiveColumns)
+	{
+		CastAdaptiveRange(game, start, end);
+		return;
+	}
+
+	SDL_AtomicAdd(&game->rayCount, end - start);
+	if (IsPacketTraversal(game))
+	{
+		for (int i = start; i < end; i += RAY_PACKET_SIZE)
+		{
+			int columns[RAY_PACKET_SIZE];
+			for (int lane = 0; lane < RAY_PACKET_SIZE; lane++)
+			{
+				columns[lane] = i + lane;
+			}
+			RaycastPacket(game, columns, min(RAY_PACKET_SIZE, end - i));
+		}
+		return;
+	}
+
+	for (int i = start; i < end; i++)
+	{
+		game->columnHits[i] = Raycast(game, i);
+	}
+
+} // CastColumnRange()
+
+// Depth at which a ray from inside the map leaves it
+double MapExitDepth(GameMap *gameMap, Vec2 mapPos, Vec2 rayDir)
+{
+	double exitX = (rayDir.x < 0) ? -mapPos.x / rayDir.x : (gameMap->width - mapPos.x) / rayDir.x;
+	double exitY = (rayDir.y < 0) ? -mapPos.y / rayDir.y : (gameMap->height - mapPos.y) / rayDir.y;
+	return min(exitX, exitY);
+
+} // MapExitDepth()
+
+// Find every column's wall by sweeping the wall faces in view, the Hits match Raycast() but for rays through exact corners
+void SweepColumns(GameState *game, int columnCount)
+{
+	WallSweep* sweep	= &game->wallSweep;
+	Vec2 mapPos			= { game->player.pos.x / GRID_RES.x, game->player.pos.y / GRID_RES.y };
+	sweep->columnCount	= columnCount; // the internal resolution can be below the columns allocated
+	for (int i = 0; i < columnCount; i++)
+	{
+		sweep->rayDirs[i] = ColumnRayDir(&game->columnRays, i);
+	}
+	const double FAR_DEPTH = game->debug.farPlane ? game->gameMap.rayLength : INFINITY;
+	SweepWallFaces(sweep, &game->gameMap, mapPos, game->player.direction, game->player.cameraPlane, FAR_DEPTH);
+
+	for (int i = 0; i < columnCount; i++)
+	{
+		Hit* hit			= &game->columnHits[i];
+		ColumnFace* face	= &sweep->columns[i];
+		if (face->depth == INFINITY)
+		{
+			memset(hit, 0, sizeof(*hit) );
+			hit->isFog = MapExitDepth(&game->gameMap, mapPos, sweep->rayDirs[i]) > FAR_DEPTH;
+			continue; // left the map or reached the far plane
+		}
+		ResolveFaceHit(game, hit, sweep->rayDirs[i], mapPos, face->mapX, face->mapY, face->isSide);
+	}
+
+} // SweepColumns()
+
+// Raycast every column of the frame into game->columnHits, spread over the worker threads
+void CastColumns(GameState *game, int columnCount)
+{
+	SDL_AtomicSet(&game->rayCount, 0);
+	if (!UpdateColumnRays(&game->columnRays, columnCount, game->player.direction, game->player.cameraPlane))
+	{
+		memset(game->columnHits, 0, sizeof(Hit) * columnCount);
+		return;
+	}
+	if (game->debug.traversal == TRAVERSAL_SWEEP)
+	{
+		SweepColumns(game, columnCount);
+		return;
+	}
+	RunThreadPool(&game->threadPool, CastColumnRange, game, columnCount, COLUMN_CHUNK);
+
+} // CastColumns()
+
+void DrawHand( GameState* game )
+{
+	const Vec2 FRAME_PADDING	= { 0.9f, 1.075f }; // for making sure hand is not completly in bottom right corner
+	Anim* handAnim				= &game->player.handAnim;
+	const double BOB_STRENGTH	= ( game->player.isMoving == FALSE ) ? 0 : handAnim->strength;
+	double timeRate				= game->timer.tickCurrent * handAnim->rate;
+	double upAnim				= sin(timeRate) * BOB_STRENGTH;
+	int handSize				= RESOLUTION.x / 2.5f;
+	double handOffsetX			= (RESOLUTION.x * FRAME_PADDING.x) - handSize;
+	double handOffsetY			= (RESOLUTION.y * FRAME_PADDING.y) - handSize - upAnim;
+
+	// Render Hand Overlay
+	SDL_Rect handRect = { (int)handOffsetX, (int)handOffsetY, handSize, handSize };
+	SDL_RenderCopy(game->renderer, game->img_Hand.img, NULL, &handRect );
+
+} // DrawHand()
+
+// Colormap light level of a Hit from its distance and side, shared by both render paths
+int CalculateLightLevel(GameMap* gameMap, Hit* hit)
+{
+	double darkness		 = (hit->isSide == FALSE) ? hit->dist * (gameMap->darknessIntensity/2.0f) : hit->dist * gameMap->darknessIntensity;
+	darkness			+= (hit->isSide == FALSE) ? 128 : 0; // side walls are automatically darker
+	return DarknessToLightLevel( (int)min( darkness, 255.0 ) );
+
+} // CalculateLightLevel()
+
+// Smallest mip level of a wall texture still at least as tall as the column it is drawn into
+Image* SelectWallMip(GameState *game, Image *wall, int columnHeight)
+{
+	Image* level = wall;
+	for (int i = 0; game->debug.mipmaps && i < wall->mipCount && wall->mips[i].height >= columnHeight; i++)
+	{
+		level = &wall->mips[i];
+	}
+	return level;
+
+} // SelectWallMip()
+
+// Draw one Column to represent world based on Raycast Hit result
+void RenderColumn(GameState *game, Hit *hit, int i )
+{
+	// Calculate Column Height based on distance and resolution
+	int columnHeight		= (int)( RESOLUTION.y / game->gameMap.wallScale / hit->dist );
+	int horizonLine			= (RESOLUTION.y / 2) - (columnHeight / 2);
+	SDL_Rect wallRect		= { i * (int)game->gameMap.columnRatio, horizonLine, (int)game->gameMap.columnRatio, columnHeight };
+
+	// Calculate horizontal UV value ( V is always spans all of texture ), texX is in full resolution texels
+	Image* wall				= SelectWallMip(game, &game->img_Wall, columnHeight);
+	const int TEX_SIZE		= wall->width - 1;
+	int texU				= (int) ( hit->texX * 0.6667f ) * wall->width / game->img_Wall.width; // multiply UV layout to account for perspective distortion
+	texU					= clampI(texU, 1, TEX_SIZE);
+
+	// Simple Shadowing, the renderer modulates the column by its light level as it draws it
+	int lightLevel			= game->debug.enabledLighting ? CalculateLightLevel( &game->gameMap, hit ) : 0;
+	Uint8 light				= game->colormap.light[lightLevel];
+
+	// Create Wall Column
+	if (game->debug.texturedWalls)
+	{
+		SDL_Rect uvRect = { texU, 0, texU, wall->height - 1 };
+		SDL_SetTextureColorMod(wall->img, light, light, light);
+		SDL_RenderCopy(game->renderer, wall->img, &uvRect, &wallRect);
+	}
+	else
+	{
+		// Render Solid Color
+		SDL_SetRenderDrawColor(game->renderer, 0, game->colormap.channel[lightLevel][255], 0, 255);
+		SDL_RenderFillRect(game->renderer, &wallRect);
+	}
+
+} // RenderColumn()
+
+// Pixel columns [startX, endX) start the frame without a wall, an empty span at the horizon
+void ClearWallSpans(GameState *game, int startX, int endX)
+{
+	const int HALF_HEIGHT = game->frameBuffer.height / 2;
+	for (int x = startX; x < endX; x++)
+	{
+		game->wallSpans[x] = (WallSpan) { HALF_HEIGHT, HALF_HEIGHT };
+	}
+
+} // ClearWallSpans()
+
+// Record the screen rows [top, bottom) a wall or fog column covers, so the background can be drawn around it
+void MarkWallSpan(GameState *game, int startX, int width, int top, int bottom)
+{
+	for (int x = max(startX, 0); x < min(startX + width, game->frameBuffer.width); x++)
+	{
+		game->wallSpans[x] = (WallSpan) { top, bottom };
+	}
+
+} // MarkWallSpan()
+
+// Write one Column straight into the Framebuffer, shaded through the colormap as texels are fetched, returns pixels written
+int RenderColumnSoftware(GameState *game, Framebuffer *frameBuffer, Hit *hit, int i )
+{
+	int columnHeight			= (int)( frameBuffer->height / game->gameMap.wallScale / hit->dist );
+	int horizonLine				= (frameBuffer->height / 2) - (columnHeight / 2);
+	int columnWidth				= (int)game->gameMap.columnRatio;
+	int startX					= i * columnWidth;
+	if ( columnHeight <= 0 )
+	{
+		return 0;
+	}
+
+	// The stretched uvRect of the SDL path lands on texX, so sample that texel column directly
+	Image* wall					= SelectWallMip( game, &game->img_Wall, columnHeight );
+	const int TEX_SIZE			= wall->width - 1;
+	int texU					= clampI( (int)hit->texX * wall->width / game->img_Wall.width, 1, TEX_SIZE );
+	const Uint32* texels		= wall->columns + texU * wall->columnPitch;
+
+	// V spans the whole texture over the column, stepped in 16.16 fixed point
+	Sint64 vStep				= ( (Sint64)( wall->height - 1 ) << 16 ) / columnHeight;
+	int startY					= max( horizonLine, 0 );
+	int endY					= min( horizonLine + columnHeight, frameBuffer->height );
+	Sint64 v					= (Sint64)( startY - horizonLine ) * vStep;
+
+	int shade					= game->debug.enabledLighting;
+	const Uint8* lightRow		= game->colormap.channel[ shade ? CalculateLightLevel( &game->gameMap, hit ) : 0 ];
+	Uint32 solidColor			= ApplyColormap( lightRow, PackColor( 0, 255, 0 ) );
+	MarkWallSpan( game, startX, columnWidth, startY, endY );
+
+	for ( int y = startY; y < endY; y++, v += vStep )
+	{
+		Uint32 color = solidColor;
+		if ( game->debug.texturedWalls )
+		{
+			color = texels[ v >> 16 ];
+			color = shade ? ApplyColormap( lightRow, color ) : color;
+		}
+
+		Uint32* dst = frameBuffer->pixels + y * frameBuffer->pitch + startX;
+		for ( int x = 0; x < columnWidth; x++ )
+		{
+			dst[x] = color;
+		}
+	}
+	return max( endY - startY, 0 ) * columnWidth;
+
+} // RenderColumnSoftware()
+
+// Fill the columns [firstColumn, endColumn) whose rays reached the far plane with a wall of fog there, runs of them
+// as one rect, into the Framebuffer or with the renderer when it is NULL. Returns Framebuffer pixels written
+int DrawFog(GameState *game, Framebuffer *frameBuffer, int firstColumn, int endColumn)
+{
+	if (!game->debug.farPlane)
+	{
+		return 0;
+	}
+
+	const int HEIGHT	= (frameBuffer != NULL) ? frameBuffer->height : RESOLUTION.y;
+	int columnHeight	= (int)( HEIGHT / game->gameMap.wallScale / game->gameMap.rayLength );
+	int horizonLine		= (HEIGHT / 2) - (columnHeight / 2);
+	int columnWidth		= (int)game->gameMap.columnRatio;
+	int written			= 0;
+	if (frameBuffer == NULL)
+	{
+		SDL_SetRenderDrawColor(game->renderer, FOG_COLOR, 255);
+	}
+	for (int first = firstColumn, last; first < endColumn; first = last + 1)
+	{
+		last = first;
+		if (game->columnHits[first].isFog == FALSE)
+		{
+			continue;
+		}
+		while (last + 1 < endColumn && game->columnHits[last + 1].isFog)
+		{
+			last++;
+		}
+
+		SDL_Rect fogRect = { first * columnWidth, horizonLine, (last - first + 1) * columnWidth, columnHeight };
+		if (frameBuffer != NULL)
+		{
+			MarkWallSpan(game, fogRect.x, fogRect.w, max(fogRect.y, 0), min(fogRect.y + fogRect.h, HEIGHT));
+			written += FillFramebufferRect(frameBuffer, fogRect.x, fogRect.y, fogRect.w, fogRect.h, PackColor( FOG_COLOR ));
+		}
+		else
+		{
+			SDL_RenderFillRect(game->renderer, &fogRect);
+		}
+	}
+	return written;
+
+} // DrawFog()
+
+// Merge adjacent columns that hit the same face ( same Hit.point and isSide ) into game->faceRuns, returns the run count
+int CollectFaceRuns(GameState *game, int columnCount)
+{
+	int runCount = 0;
+	for (int i = 0; i < columnCount; i++)
+	{
+		Hit* hit = &game->columnHits[i];
+		if (hit->isHit == FALSE)
+		{
+			continue;
+		}
+
+		Hit* previous	= &game->columnHits[max(i - 1, 0)];
+		int sameFace	= runCount > 0 && game->faceRuns[runCount - 1].last == i - 1 &&
+						  previous->point.x == hit->point.x && previous->point.y == hit->point.y && previous->isSide == hit->isSide;
+		if (sameFace)
+		{
+			game->faceRuns[runCount - 1].last = i;
+			continue;
+		}
+		game->faceRuns[runCount++] = (FaceRun) { i, i };
+	}
+	return runCount;
+
+} // CollectFaceRuns()
+
+// Draw each run as one trapezoid from the Hits at its ends. A wall face is flat, so 1 / dist and U / dist
+// are linear across the screen, which gives every column in between its perspective-correct height and U.
+// Only the columns [firstColumn, endColumn) are drawn, returns pixels written
+int DrawFaceRuns(GameState *game, Framebuffer *frameBuffer, int runCount, int firstColumn, int endColumn)
+{
+	Vec2 mapPos = { game->player.pos.x / GRID_RES.x, game->player.pos.y / GRID_RES.y };
+	int written	= 0;
+	for (int r = 0; r < runCount; r++)
+	{
+		FaceRun* run	= &game->faceRuns[r];
+		Hit* first		= &game->columnHits[run->first];
+		Hit* last		= &game->columnHits[run->last];
+		const int START	= max(run->first, firstColumn);
+		const int END	= min(run->last + 1, endColumn);
+		if (START >= END)
+		{
+			continue;
+		}
+		if (first->dist <= 0 || last->dist <= 0)
+		{
+			for (int i = START; i < END; i++)
+			{
+				written += RenderColumnSoftware(game, frameBuffer, &game->columnHits[i], i);
+			}
+			continue;
+		}
+
+		// Unrounded U at both ends, Hit.texX is already a whole texel
+		Vec2 firstDir			= ColumnRayDir(&game->columnRays, run->first);
+		Vec2 lastDir			= ColumnRayDir(&game->columnRays, run->last);
+		const double U_FIRST	= WallTexCoord(game, first->isSide, firstDir, mapPos, first->point.x, first->point.y, first->dist);
+		const double U_LAST		= WallTexCoord(game, last->isSide, lastDir, mapPos, last->point.x, last->point.y, last->dist);
+
+		const double SPAN		= max(run->last - run->first, 1);
+		const double INV_FIRST	= 1.0 / first->dist;
+		const double INV_LAST	= 1.0 / last->dist;
+		Hit column				= *first;
+		for (int i = START; i < END; i++)
+		{
+			double t		= (i - run->first) / SPAN;
+			double invDist	= INV_FIRST + (INV_LAST - INV_FIRST) * t;
+			double u		= ( U_FIRST * INV_FIRST + (U_LAST * INV_LAST - U_FIRST * INV_FIRST) * t ) / invDist;
+			column.dist		= 1.0 / invDist;
+			column.texX		= MirrorTexX(game, column.isSide, firstDir, u);
+			written += RenderColumnSoftware(game, frameBuffer, &column, i);
+		}
+	}
+	return written;
+
+} // DrawFaceRuns()
+
+// SDL path: the coalesced faces go into a transparent layer drawn over the background in a single draw call,
+// since this SDL version has no geometry submission to hand the trapezoids to the renderer directly
+void DrawFaceRunLayer(GameState *game, int columnCount)
+{
+	Framebuffer* layer = &game->wallLayer;
+	FillFramebufferRect(layer, 0, 0, layer->width, layer->height, 0);
+	DrawFaceRuns(game, layer, CollectFaceRuns(game, columnCount), 0, columnCount);
+	DrawFog(game, layer, 0, columnCount);
+	PresentFramebuffer(game->renderer, layer);
+
+} // DrawFaceRunLayer()
+
+// Perspective correct floor in pixel columns [startX, endX), every row below the horizon also textures the ceiling row
+// mirrored above it. With spans only the pixels around each column's wall are written, returns pixels written
+int CastFloorRows(GameState *game, Framebuffer *frameBuffer, const WallSpan *spans, int startX, int endX)
+{
+	Player* player				= &game->player;
+	Image* floor				= &game->img_Floor;
+	const int HALF_HEIGHT		= frameBuffer->height / 2;
+	const int SHADE				= game->debug.enabledLighting;
+
+	// Rays through the left and right screen edges, the floor under a row runs between where they meet it
+	Vec2 mapPos					= { player->pos.x / GRID_RES.x, player->pos.y / GRID_RES.y };
+	Vec2 pixelDir				= { 2.0 * player->cameraPlane.x / frameBuffer->width, 2.0 * player->cameraPlane.y / frameBuffer->width };
+	Vec2 leftDir				= { player->direction.x - player->cameraPlane.x + startX * pixelDir.x, player->direction.y - player->cameraPlane.y + startX * pixelDir.y };
+
+	// Rows between the lowest wall top and the highest wall bottom are wall in every column, nothing to cast there
+	int coveredTop				= HALF_HEIGHT;
+	int coveredBottom			= HALF_HEIGHT;
+	if ( spans != NULL )
+	{
+		coveredTop				= 0;
+		coveredBottom			= frameBuffer->height;
+		for ( int x = startX; x < endX; x++ )
+		{
+			coveredTop			= max( coveredTop, spans[x].top );
+			coveredBottom		= min( coveredBottom, spans[x].bottom );
+		}
+	}
+
+	int written = 0;
+	for ( int row = 0; row < frameBuffer->height - HALF_HEIGHT; row++ )
+	{
+		int floorY				= HALF_HEIGHT + row;
+		int ceilingY			= HALF_HEIGHT - 1 - row;
+		if ( floorY < coveredBottom && ceilingY >= coveredTop )
+		{
+			continue;
+		}
+
+		// The wall projection solved for distance: a wall whose bottom edge lands on this row stands this far away
+		double rowDist			= frameBuffer->height / ( 2.0 * game->gameMap.wallScale * ( row + 0.5 ) );
+		Vec2 start				= { mapPos.x + rowDist * leftDir.x, mapPos.y + rowDist * leftDir.y };
+		Vec2 step				= { rowDist * pixelDir.x, rowDist * pixelDir.y };
+		FloorRow floorRow		= SetupFloorRow( start, step );
+
+		double darkness			= rowDist * ( game->gameMap.darknessIntensity / 2.0f );
+		const Uint8* floorLight	= SHADE ? game->colormap.channel[ DarknessToLightLevel( (int)min( darkness, 255.0 ) ) ] : NULL;
+		const Uint8* ceilLight	= SHADE ? game->colormap.channel[ DarknessToLightLevel( (int)min( darkness + CEILING_DARKNESS, 255.0 ) ) ] : NULL;
+
+		written += CastFloorRow( &floorRow, floor->pixels, floor->width, floor->height, endX - startX, spans ? spans + startX : NULL,
+								 floorY, frameBuffer->pixels + floorY * frameBuffer->pitch + startX, floorLight,
+								 ceilingY, ( ceilingY >= 0 ) ? frameBuffer->pixels + ceilingY * frameBuffer->pitch + startX : NULL, ceilLight );
+	}
+	return written;
+
+} // CastFloorRows()
+
+// Cast floor and ceiling, or the ceiling fill and floor stretch without floor casting, in pixel columns [startX, endX).
+// With spans ( walls already drawn ) only the pixels above and below each column's wall are written, returns pixels written
+int DrawBackgroundSoftware(GameState *game, const WallSpan *spans, int startX, int endX)
+{
+	Framebuffer* frameBuffer	= &game->frameBuffer;
+	Image* floor				= &game->img_Floor;
+	const int HALF_HEIGHT		= frameBuffer->height / 2;
+
+	if ( game->debug.floorCasting )
+	{
+		return CastFloorRows( game, frameBuffer, spans, startX, endX );
+	}
+
+	int written					= 0;
+	const Uint32 CEILING		= PackColor( CEILING_COLOR );
+	for ( int y = 0; y < HALF_HEIGHT; y++ )
+	{
+		Uint32* dst = frameBuffer->pixels + y * frameBuffer->pitch;
+		for ( int x = startX; x < endX; x++ )
+		{
+			if ( spans == NULL || y < spans[x].top )
+			{
+				dst[x] = CEILING;
+				written++;
+			}
+		}
+	}
+
+	// Floor ( Bottom Half of screen ), stepped in 16.16 fixed point
+	Sint64 uStep = ( (Sint64)floor->width << 16 ) / frameBuffer->width;
+	for ( int y = HALF_HEIGHT; y < frameBuffer->height; y++ )
+	{
+		int texV			= ( ( y - HALF_HEIGHT ) * floor->height ) / ( frameBuffer->height - HALF_HEIGHT );
+		const Uint32* src	= floor->pixels + texV * floor->width;
+		Uint32* dst			= frameBuffer->pixels + y * frameBuffer->pitch;
+		Sint64 u			= startX * uStep;
+		for ( int x = startX; x < endX; x++, u += uStep )
+		{
+			if ( spans == NULL || y >= spans[x].bottom )
+			{
+				dst[x] = src[ u >> 16 ];
+				written++;
+			}
+		}
+	}
+	return written;
+
+} // DrawBackgroundSoftware()
+
+// Worker job, pixel columns [start, end) of the Framebuffer: walls, fog, floor and ceiling of that strip.
+// Strips are whole cache lines of every row, so no two workers ever write the same line
+void RasterizeStrip(void *context, int start, int end, int worker)
+{
+	GameState* game				= (GameState*)context;
+	Framebuffer* frameBuffer	= &game->frameBuffer;
+	const int COLUMN_COUNT		= frameBuffer->width * (int)COLUMN_RATIO;
+	const int COLUMN_WIDTH		= (int)game->gameMap.columnRatio;
+	const int FIRST_COLUMN		= (start + COLUMN_WIDTH - 1) / COLUMN_WIDTH; // columns starting inside the strip
+	const int END_COLUMN		= min((end + COLUMN_WIDTH - 1) / COLUMN_WIDTH, COLUMN_COUNT);
+
+	// Span composition draws the walls first and the background around them afterwards,
+	// otherwise the background fills the strip and the walls are painted over it
+	const int COMPOSE_SPANS		= game->debug.spanComposition;
+	int written					= 0;
+	ClearWallSpans(game, start, end);
+	if (!COMPOSE_SPANS)
+	{
+		written += DrawBackgroundSoftware(game, NULL, start, end);
+	}
+
+	if (game->debug.coalesceFaces)
+	{
+		written += DrawFaceRuns(game, frameBuffer, game->faceRunCount, FIRST_COLUMN, END_COLUMN);
+	}
+	else
+	{
+		for (int i = FIRST_COLUMN; i < END_COLUMN; i++)
+		{
+			Hit* hit = &game->columnHits[i];
+			if (hit->isHit == TRUE)
+			{
+				written += RenderColumnSoftware(game, frameBuffer, hit, i);
+			}
+		}
+	}
+	written += DrawFog(game, frameBuffer, FIRST_COLUMN, END_COLUMN);
+
+	if (COMPOSE_SPANS)
+	{
+		written += DrawBackgroundSoftware(game, game->wallSpans, start, end);
+	}
+	SDL_AtomicAdd(&game->pixelWrites, written);
+
+} // RasterizeStrip()
+
+// Frame-time governor: move the render scale towards the one whose frames cost RENDER_BUDGET_MS. The cost goes with
+// the pixel count, so it is tracked as the cost of a whole window sized frame and that scale is sqrt( budget / cost ).
+// While the current size costs 75% to 100% of the budget it holds still, so the resolution does not flicker
+void UpdateRenderScale(GameState *game, double renderMs)
+{
+	const double PIXELS	= (double)game->frameBuffer.width * game->frameBuffer.height / ( (double)RESOLUTION.x * RESOLUTION.y );
+	double fullCost		= renderMs / PIXELS;
+	game->renderCost	= (game->renderCost <= 0) ? fullCost : game->renderCost + (fullCost - game->renderCost) * 0.1; // smoothed, one slow frame is not load
+	if (!game->debug.dynamicResolution)
+	{
+		return;
+	}
+
+	double cost = game->renderCost * PIXELS;
+	if (cost > RENDER_BUDGET_MS || cost < RENDER_BUDGET_MS * 0.75)
+	{
+		double target		= sqrt(RENDER_BUDGET_MS / game->renderCost);
+		game->renderScale	+= clamp(target - game->renderScale, -RENDER_SCALE_STEP, RENDER_SCALE_STEP);
+		game->renderScale	= clamp(game->renderScale, MIN_RENDER_SCALE, 1.0);
+	}
+
+} // UpdateRenderScale()
+
+// Size the Framebuffer for this frame: the render scale of the window in the Framebuffer path, the window size otherwise.
+// The width is kept to whole cache lines of pixels and the height follows it, so the aspect ratio is the window's
+void ApplyRenderScale(GameState *game)
+{
+	const int LINE_PIXELS	= FRAMEBUFFER_ALIGN / sizeof(Uint32);
+	int scaled				= game->debug.softwareRender && game->debug.dynamicResolution && !game->debug.displayMap;
+	int width				= scaled ? (int)(RESOLUTION.x * game->renderScale) / LINE_PIXELS * LINE_PIXELS : RESOLUTION.x;
+	width					= max(width, LINE_PIXELS);
+	int height				= scaled ? (int)((double)width * RESOLUTION.y / RESOLUTION.x + 0.5) : RESOLUTION.y;
+#if BENCHMARK
+	if (scaled && (width != game->frameBuffer.width || height != game->frameBuffer.height))
+	{
+		printf("Render: %dx%d, %.2f ms at window size \n", width, height, game->renderCost);
+	}
+#endif
+	SetFramebufferSize(&game->frameBuffer, width, height);
+
+} // ApplyRenderScale()
+
+// Cast and rasterize the Player's view into the Framebuffer's pixels only, the renderer is not touched
+void RasterizeWorld(GameState *game)
+{
+	const int COLUMN_COUNT	= game->frameBuffer.width * (int)COLUMN_RATIO;
+	CastColumns(game, COLUMN_COUNT);
+	game->faceRunCount		= game->debug.coalesceFaces ? CollectFaceRuns(game, COLUMN_COUNT) : 0;
+
+	// The same strips either way, so both give the exact same pixels
+	const int WIDTH = game->frameBuffer.width;
+	if (game->debug.parallelRaster)
+	{
+		RunThreadPool(&game->threadPool, RasterizeStrip, game, WIDTH, RASTER_STRIP);
+	}
+	else
+	{
+		for (int x = 0; x < WIDTH; x += RASTER_STRIP)
+		{
+			RasterizeStrip(game, x, min(x + RASTER_STRIP, WIDTH), 0);
+		}
+	}
+
+} // RasterizeWorld()
+
+// Render the Game World in 2.5D into the Framebuffer, uploaded with a single draw call
+void DrawWorldSoftware(GameState *game)
+{
+	// The Framebuffer texture still holds this exact frame
+	if (game->isStaticFrame)
+	{
+		DrawFramebuffer(game->renderer, &game->frameBuffer);
+		return;
+	}
+
+	// The internal resolution may be below the window's, the upscale happens as the Framebuffer is drawn
+	Uint64 renderStart = SDL_GetPerformanceCounter();
+	RasterizeWorld(game);
+	UpdateRenderScale(game, (SDL_GetPerformanceCounter() - renderStart) * 1000.0 / SDL_GetPerformanceFrequency());
+
+	PresentFramebuffer(game->renderer, &game->frameBuffer);
+
+} // DrawWorldSoftware()
+
+// Render the Game World in 2.5D 
+void DrawWorld(GameState *game)
+{
+	if ( !game->debug.displayMap && game->debug.floorCasting )
+	{
+		// Cast Floor and Ceiling on the CPU, a static frame's are still in the Framebuffer texture
+		if (game->isStaticFrame)
+		{
+			DrawFramebuffer(game->renderer, &game->frameBuffer);
+		}
+		else
+		{
+			DrawBackgroundSoftware(game, NULL, 0, game->frameBuffer.width);
+			PresentFramebuffer(game->renderer, &game->frameBuffer);
+		}
+	}
+	else if ( !game->debug.displayMap )
+	{
+		// Draw Ceiling, over the whole screen unless composing spans. Only the Framebuffer paths compose whole spans,
+		// the SDL renderer still copies the floor under every wall and draws the walls over it
+		SDL_SetRenderDrawColor(game->renderer, CEILING_COLOR, 255); // Near Black
+		SDL_Rect wallRect = { 0, 0, RESOLUTION.x, game->debug.spanComposition ? RESOLUTION.y / 2 : RESOLUTION.y }; // Top Half of Screen
+		SDL_RenderFillRect(game->renderer, &wallRect);
+
+		// Draw Floor
+		SDL_Rect floorRect = { 0, RESOLUTION.y / 2, RESOLUTION.x, RESOLUTION.y / 2 }; // Bottom Half of screen
+		SDL_RenderCopy(game->renderer, game->img_Floor.img, NULL, &floorRect);
+	}
+
+	// Raycast and draw the World, static frames keep the Hits they have
+	const int COLUMN_COUNT = (int)RESOLUTION.x * (int)COLUMN_RATIO;
+	if (!game->isStaticFrame)
+	{
+		CastColumns(game, COLUMN_COUNT);
+	}
+	VecI2 view = GetMapViewOffset(game);
+	int i = 0;
+	for (i = 0; i < COLUMN_COUNT; i++)
+	{
+		Hit hit = game->columnHits[i];
+		if (hit.isHit == TRUE)
+		{
+			if (game->debug.drawRays) // Debug Draw Rays
+			{
+				SDL_SetRenderDrawColor(game->renderer, 255, 0, 0, SDL_ALPHA_OPAQUE);
+				SDL_RenderDrawLine(game->renderer, hit.x - view.x, hit.y - view.y, hit.end.x - view.x, hit.end.y - view.y );
+
+				// Draw Hit Point Rects TODO: put in own function
+				SDL_Rect hitRect = { hit.point.x * GRID_RES.x - view.x, hit.point.y * GRID_RES.y - view.y, GRID_RES.x, GRID_RES.y };
+				if (hit.isSide == TRUE)
+				{
+					SDL_SetRenderDrawColor(game->renderer, 255, 255, 128, SDL_ALPHA_OPAQUE);
+				}
+				else
+				{
+					SDL_SetRenderDrawColor(game->renderer, 128, 255, 255, SDL_ALPHA_OPAQUE);
+				}
+				SDL_RenderFillRect(game->renderer, &hitRect);
+
+				if (game->debug.displayMap)
+				{
+					continue;
+				}
+			}
+			if (!game->debug.coalesceFaces)
+			{
+				RenderColumn(game, &hit, i);
+			}
+		}
+
+	} // for
+
+	if (!game->debug.coalesceFaces && !game->debug.displayMap)
+	{
+		DrawFog(game, NULL, 0, COLUMN_COUNT);
+	}
+	if (game->debug.coalesceFaces && !game->debug.displayMap)
+	{
+		if (game->isStaticFrame)
+		{
+			DrawFramebuffer(game->renderer, &game->wallLayer);
+		}
+		else
+		{
+			DrawFaceRunLayer(game, COLUMN_COUNT);
+		}
+	}
+
+} // DrawWorld()
+
+// Compare what this frame depends on against the last one, static frames skip casting and rasterization
+void UpdateFrameCache( GameState *game )
+{
+	FrameKey key;
+	memset( &key, 0, sizeof(key) );
+	key.pos			= game->player.pos;
+	key.direction	= game->player.direction;
+	key.cameraPlane	= game->player.cameraPlane;
+	key.mapRevision	= game->gameMap.revision;
+	key.renderSize	= (VecI2) { game->frameBuffer.width, game->frameBuffer.height };
+	key.debug		= game->debug;
+
+	// Walls drawn column by column with SDL_RenderCopy() leave no target to present again, that path redraws every frame
+	const int IS_CACHED	= game->debug.frameCache && ( game->debug.softwareRender || game->debug.coalesceFaces );
+	game->isStaticFrame	= IS_CACHED && memcmp( &key, &game->frameKey, sizeof(key) ) == 0;
+	game->frameKey		= key;
+
+} // UpdateFrameCache()
+
+void DoRender( GameState *game )
+{
+	ApplyRenderScale( game );
+	UpdateFrameCache( game );
+	SDL_AtomicSet( &game->pixelWrites, 0 );
+
+	// Clear Screen, the 3D view covers every pixel when composing spans
+	if ( game->debug.displayMap || !game->debug.spanComposition )
+	{
+		SDL_SetRenderDrawColor( game->renderer, 0, 0, 255, 255);
+		SDL_RenderClear(game->renderer);
+	}
+
+	if ( game->debug.displayMap ) // / Debug Draw Topdown 2D Map
+	{ 	
+		DrawMap(game);
+		DebugDrawPlayer(game);
+		if (game->debug.drawRays)
+		{
+			DrawWorld(game);
+		}
+	}
+	else if ( game->debug.softwareRender ) // Render 2.5D World into the Framebuffer
+	{
+		DrawWorldSoftware(game);
+		DrawHand(game);
+	}
+	else // Render 2.5D World
+	{
+		DrawWorld(game);
+		DrawHand(game);
+	}
+
+	// Flag Ready to Render
+	SDL_RenderPresent(game->renderer);
+
+} // DoRender()
+
+void LoadImage( SDL_Renderer* renderer, const char* imgPath, Image* imageTo )
+{
+	SDL_Surface* imgSurface = NULL;
+	imgSurface = IMG_Load(imgPath);
+	if ( imgSurface == NULL)
+	{
+		printf("Cannot find: %s \n\n", imgPath );
+		SDL_Quit();
+		exit(1);
+	}
+
+	imageTo->img = SDL_CreateTextureFromSurface( renderer, imgSurface );
+	SDL_QueryTexture( imageTo->img, NULL, NULL, &imageTo->width, &imageTo->height );
+
+	// Keep a tightly packed CPU copy for the software render path
+	SDL_Surface* converted = SDL_ConvertSurfaceFormat( imgSurface, FRAMEBUFFER_FORMAT, 0 );
+	SDL_FreeSurface( imgSurface );
+	if ( converted == NULL )
+	{
+		printf("Cannot convert: %s \n\n", imgPath );
+		SDL_Quit();
+		exit(1);
+	}
+	imageTo->width	= converted->w;
+	imageTo->height	= converted->h;
+	imageTo->pixels	= malloc( sizeof(Uint32) * converted->w * converted->h );
+	if ( imageTo->pixels == NULL )
+	{
+		printf("Cannot allocate pixels of: %s \n\n", imgPath );
+		SDL_FreeSurface( converted );
+		SDL_Quit();
+		exit(1);
+	}
+	SDL_LockSurface( converted );
+	for ( int row = 0; row < converted->h; row++ )
+	{
+		memcpy( imageTo->pixels + row * converted->w, (Uint8*)converted->pixels + row * converted->pitch, sizeof(Uint32) * converted->w );
+	}
+	SDL_UnlockSurface( converted );
+	SDL_FreeSurface( converted );
+
+} // LoadImage()
+
+// Transposed copy of the texels, so walking down a wall column reads one contiguous run instead of a stride per texel
+void BuildImageColumns( Image* image )
+{
+	const int TEXELS_PER_LINE	= CACHE_LINE / sizeof(Uint32);
+	image->columnPitch			= ( image->height + TEXELS_PER_LINE - 1 ) / TEXELS_PER_LINE * TEXELS_PER_LINE;
+	image->columns				= _mm_malloc( sizeof(Uint32) * image->columnPitch * image->width, CACHE_LINE );
+	if ( image->columns == NULL )
+	{
+		printf("Cannot allocate texture columns \n\n" );
+		SDL_Quit();
+		exit(1);
+	}
+
+	for ( int x = 0; x < image->width; x++ )
+	{
+		Uint32* column = image->columns + x * image->columnPitch;
+		for ( int y = 0; y < image->height; y++ )
+		{
+			column[y] = image->pixels[ y * image->width + x ];
+		}
+	}
+
+} // BuildImageColumns()
+
+// Average of four texels, per channel
+Uint32 AverageTexels( Uint32 a, Uint32 b, Uint32 c, Uint32 d )
+{
+	Uint32 result = 0;
+	for ( int shift = 0; shift < 32; shift += 8 )
+	{
+		Uint32 sum	= ( ( a >> shift ) & 0xFF ) + ( ( b >> shift ) & 0xFF ) + ( ( c >> shift ) & 0xFF ) + ( ( d >> shift ) & 0xFF );
+		result		|= ( ( sum + 2 ) / 4 ) << shift;
+	}
+	return result;
+
+} // AverageTexels()
+
+// Box filtered levels, each half the size of the one before, down to MIN_MIP_SIZE. Every level gets its own
+// texture for the SDL path and column-major texels for the software path
+void BuildMipChain( SDL_Renderer* renderer, Image* image )
+{
+	SDL_BlendMode blendMode = SDL_BLENDMODE_NONE;
+	SDL_GetTextureBlendMode( image->img, &blendMode );
+
+	image->mipCount = 0;
+	for ( int w = image->width / 2, h = image->height / 2; w >= MIN_MIP_SIZE && h >= MIN_MIP_SIZE; w /= 2, h /= 2 )
+	{
+		image->mipCount++;
+	}
+	image->mips = calloc( max( image->mipCount, 1 ), sizeof(Image) );
+	if ( image->mips == NULL )
+	{
+		printf("Cannot allocate mip levels \n\n" );
+		SDL_Quit();
+		exit(1);
+	}
+
+	const Image* parent = image;
+	for ( int i = 0; i < image->mipCount; i++ )
+	{
+		Image* level	= &image->mips[i];
+		level->width	= parent->width / 2;
+		level->height	= parent->height / 2;
+		level->pixels	= malloc( sizeof(Uint32) * level->width * level->height );
+		if ( level->pixels == NULL )
+		{
+			printf("Cannot allocate mip levels \n\n" );
+			SDL_Quit();
+			exit(1);
+		}
+
+		for ( int y = 0; y < level->height; y++ )
+		{
+			const Uint32* top		= parent->pixels + ( y * 2 ) * parent->width;
+			const Uint32* bottom	= top + parent->width;
+			for ( int x = 0; x < level->width; x++ )
+			{
+				level->pixels[ y * level->width + x ] = AverageTexels( top[x * 2], top[x * 2 + 1], bottom[x * 2], bottom[x * 2 + 1] );
+			}
+		}
+
+		level->img = SDL_CreateTexture( renderer, FRAMEBUFFER_FORMAT, SDL_TEXTUREACCESS_STATIC, level->width, level->height );
+		if ( level->img != NULL )
+		{
+			SDL_UpdateTexture( level->img, NULL, level->pixels, level->width * sizeof(Uint32) );
+			SDL_SetTextureBlendMode( level->img, blendMode );
+		}
+		BuildImageColumns( level );
+		parent = level;
+	}
+
+} // BuildMipChain()
+
+void FreeImage( Image* image )
+{
+	for ( int i = 0; i < image->mipCount; i++ )
+	{
+		FreeImage( &image->mips[i] );
+	}
+	free( image->mips );
+	SDL_DestroyTexture( image->img );
+	free( image->pixels );
+	_mm_free( image->columns );
+	memset( image, 0, sizeof *image );
+
+} // FreeImage()
+
+void GetResources( GameState* game )
+{
+	LoadImage(game->renderer, CHECKER_PATH,		&game->img_Checker );
+	LoadImage(game->renderer, WALL_PATH,		&game->img_Wall );
+	BuildImageColumns( &game->img_Wall );
+	BuildMipChain( game->renderer, &game->img_Wall );
+	LoadImage(game->renderer, FLOOR_PATH,		&game->img_Floor );
+	LoadImage(game->renderer, HAND_PATH,		&game->img_Hand );
+
+} // GetResources()
+
+// viewSize is the size the view buffers are built for, RESOLUTION for the window
+void LoadGame( GameState* game, VecI2 viewSize )
+{
+	// Seed the pseudo-random number generator
+	srand((int)time(NULL)); 
+
+	// Load all textures etc needed for game
+	GetResources( game );
+	if ( !AllocateViewBuffers( game, viewSize ) )
+	{
+		SDL_Quit();
+		exit(1);
+	}
+
+	// Wall shading tables
+	BuildColormap( &game->colormap );
+
+	// Column Raycasting Workers
+	CreateThreadPool( &game->threadPool, WORKER_THREADS );
+
+	// Player Setup
+	InitializePlayer( &game->player );
+
+	// Setup GameMap
+	InitializeMap(&game->gameMap, RAY_LENGTH, COLUMN_RATIO, WALL_SCALE, DARKNESS_INTENSITY, REPEAT_WALL );
+
+} // LoadGame()
+
+// Write out Debug Benchmark Info to File
+void DebugOutput(const char* outputText)
+{
+	// Debug Output To File Setup
+	SDL_RWops* debugFile = SDL_RWFromFile(DEBUG_PATH, "a+");
+	if (debugFile == NULL)
+	{
+		printf("Warning: Unable to open file! SDL Error: %s\n", SDL_GetError());
+		printf("New file created!\n");
+		debugFile = SDL_RWFromFile(DEBUG_PATH, "+");
+	}
+	if (debugFile != NULL)
+	{
+		printf("Writing to File! \n");
+		size_t len = SDL_strlen(outputText);
+		SDL_RWwrite(debugFile, outputText, 1, len);
+
+		//Close file handler 
+		SDL_RWclose(debugFile);
+	}
+
+} // DebugOutput()
+
+void UpdateTime( Timer* timer )
+{
+	// Delta Time
+	timer->perfPrevious		= timer->perfCurrent;
+	timer->perfCurrent		= SDL_GetPerformanceCounter();
+	timer->deltaTime		= (timer->perfCurrent - timer->perfPrevious) / (double)SDL_GetPerformanceFrequency();
+
+	// Frame Rate
+	timer->tickPrevious		= timer->tickCurrent;
+	timer->tickCurrent		= SDL_GetTicks();
+	timer->frameRate		= 1000.0f / (timer->tickCurrent - timer->tickPrevious );
+
+	printf("DT: %f \n", timer->deltaTime);
+	printf("FPS: %d \n", (int)timer->frameRate);
+
+} // UpdateTime()
+
+int Benchmark()
+{
+#if BENCHMARK
+	double timeInSeconds	= (int)clock() / CLOCKS_PER_SEC;
+
+	if (timeInSeconds >= 5 )
+	{
+		char* output = malloc(16);
+		snprintf(output, 16, "\n Timing: %d", SDL_GetTicks() );
+		DebugOutput(output);
+		return TRUE;
+	}
+	return FALSE;
+#else
+	return FALSE;
+#endif
+
+} // Benchmark()
+
+// Average DDA iterations and time per ray of each traversal, from a grid of empty cells over a fan of directions
+void BenchmarkTraversals(GameState *game)
+{
+	static const char* NAMES[]	= { "Scalar", "Packet", "Occupancy", "Distance" };
+	const int DIRECTIONS		= 256;
+	const double TWO_PI			= 6.283185307179586;
+	const GameMap* gameMap		= &game->gameMap;
+	const int STRIDE			= max( 1, (int)sqrt( gameMap->width * (double)gameMap->height / 1024 ) ); // about 1024 start cells
+
+	for (int traversal = TRAVERSAL_SCALAR; traversal <= TRAVERSAL_DISTANCE; traversal++)
+	{
+		if (traversal == TRAVERSAL_PACKET)
+		{
+			continue; // steps exactly like TRAVERSAL_SCALAR
+		}
+
+		int iterations	= 0;
+		int rays		= 0;
+		Uint64 start	= SDL_GetPerformanceCounter();
+		for (int y = 0; y < gameMap->height; y += STRIDE)
+		{
+			for (int x = 0; x < gameMap->width; x += STRIDE)
+			{
+				if (GetTile(gameMap, x, y) > 0)
+				{
+					continue;
+				}
+				for (int i = 0; i < DIRECTIONS; i++)
+				{
+					double angle = TWO_PI * (i + 0.5) / DIRECTIONS;
+					RayState ray;
+					InitRayState(&ray, vec2(x + 0.5, y + 0.5), vec2(cos(angle), sin(angle)));
+					WalkRay(&ray, gameMap, traversal, &iterations);
+					rays++;
+				}
+			}
+		}
+		double seconds = (SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency();
+
+		char output[128];
+		snprintf(output, sizeof(output), "\n %s: %.2f steps per ray, %.1f ns per ray ( %d rays )", NAMES[traversal],
+			iterations / (double)max(rays, 1), seconds * 1e9 / max(rays, 1), rays);
+		DebugOutput(output);
+		printf("%s \n", output + 2);
+	}
+
+} // BenchmarkTraversals()
+
+// Writes a ray that ended elsewhere than the scalar walk to the debug output, returns 1 when it did
+int CompareRayEnd(const char* name, Vec2 mapPos, Vec2 rayDir, double farDist, int status, VecI2 cell, int isSide, VecI2 steps, const RayState* expected, int expectedStatus)
+{
+	if (status == expectedStatus && cell.x == expected->mapX && cell.y == expected->mapY && isSide == expected->isSide &&
+		steps.x == expected->steps.x && steps.y == expected->steps.y)
+	{
+		return 0;
+	}
+
+	char output[224];
+	snprintf(output, sizeof(output), "\n %s ray from ( %.3f, %.3f ) along ( %.4f, %.4f ), far %.2f: status %d at ( %d, %d ), scalar walk %d at ( %d, %d )",
+		name, mapPos.x, mapPos.y, rayDir.x, rayDir.y, farDist, status, cell.x, cell.y, expectedStatus, expected->mapX, expected->mapY);
+	DebugOutput(output);
+	return 1;
+
+} // CompareRayEnd()
+
+// Every traversal and the packet kernel against TRAVERSAL_SCALAR in a corridor with open ends, so rays leave the map,
+// and far planes inside it, so rays stop short of that. Returns the rays that ended in a different state
+int CheckTraversals(void)
+{
+	static const char* NAMES[]	= { "Scalar", "Packet", "Occupancy", "Distance" };
+	const double FAR_DISTS[]	= { 20.0, 7.25, INFINITY };
+	const int WIDTH				= 64;
+	const int HEIGHT			= 8;
+	const int STARTS			= 12;
+	const int DIRECTIONS		= 200;
+	const double TWO_PI			= 6.283185307179586;
+
+	GameMap gameMap;
+	memset(&gameMap, 0, sizeof(gameMap) );
+	if (!AllocateMapCells(&gameMap, WIDTH, HEIGHT))
+	{
+		FreeMap(&gameMap);
+		return 1;
+	}
+	for (int x = 0; x < WIDTH; x++)
+	{
+		SetTile(&gameMap, x, 0, 1);
+		SetTile(&gameMap, x, HEIGHT - 1, 1);
+	}
+	SetTile(&gameMap, WIDTH * 5 / 8, HEIGHT / 2, 1); // a pillar in the way of some rays
+	BuildDistanceField(&gameMap.distanceField, &gameMap.occupancy);
+
+	int rays = 0, mismatches = 0;
+	for (int f = 0; f < 3; f++)
+	{
+		for (int start = 0; start < STARTS; start++)
+		{
+			Vec2 mapPos = vec2(1.3 + start * 0.45, 1.2 + (start % 6) * 0.93);
+			for (int i = 0; i < DIRECTIONS; i += RAY_PACKET_SIZE)
+			{
+				RayState expected[RAY_PACKET_SIZE];
+				int expectedStatus[RAY_PACKET_SIZE];
+				RayPacket packet;
+				packet.mapPos	= mapPos;
+				packet.startPos	= mapPos;
+				for (int lane = 0; lane < RAY_PACKET_SIZE; lane++)
+				{
+					// Every other ray runs within a few degrees of the corridor, where the empty runs are longest
+					int n			= i + lane;
+					double angle	= (n % 2 == 0) ? TWO_PI * (n + 0.5) / DIRECTIONS : ((n % 4 == 1) ? 0 : TWO_PI / 2) + (n - DIRECTIONS / 2) * 0.0007;
+					Vec2 rayDir		= vec2(cos(angle), sin(angle));
+					Vec2 deltaDist	= vec2(sqrt(1 + square(rayDir.y) / square(rayDir.x)), sqrt(1 + square(rayDir.x) / square(rayDir.y)));
+					InitRayStateDelta(&expected[lane], mapPos, rayDir, deltaDist);
+					SetRayFarPlane(&expected[lane], FAR_DISTS[f], 1.0);
+					expectedStatus[lane] = WalkRay(&expected[lane], &gameMap, TRAVERSAL_SCALAR, NULL);
+
+					for (int traversal = TRAVERSAL_OCCUPANCY; traversal <= TRAVERSAL_DISTANCE; traversal++)
+					{
+						RayState ray;
+						InitRayStateDelta(&ray, mapPos, rayDir, deltaDist);
+						SetRayFarPlane(&ray, FAR_DISTS[f], 1.0);
+						int status	= WalkRay(&ray, &gameMap, traversal, NULL);
+						mismatches	+= CompareRayEnd(NAMES[traversal], mapPos, rayDir, FAR_DISTS[f], status, vecI2(ray.mapX, ray.mapY), ray.isSide, ray.steps, &expected[lane], expectedStatus[lane]);
+					}
+
+					packet.rayDirX[lane]	= rayDir.x;
+					packet.rayDirY[lane]	= rayDir.y;
+					packet.deltaDistX[lane]	= deltaDist.x;
+					packet.deltaDistY[lane]	= deltaDist.y;
+					packet.farDist[lane]	= FAR_DISTS[f];
+					rays++;
+				}
+
+				TraversePacket(&gameMap, &packet, RAY_PACKET_SIZE);
+				for (int lane = 0; lane < RAY_PACKET_SIZE && IS_PACKET_EXACT; lane++)
+				{
+					int status	= packet.isHit[lane] ? RAY_HIT : packet.isFar[lane] ? RAY_PAST_FAR : RAY_LEFT_MAP;
+					mismatches	+= CompareRayEnd(NAMES[TRAVERSAL_PACKET], mapPos, vec2(packet.rayDirX[lane], packet.rayDirY[lane]), FAR_DISTS[f], status,
+						vecI2(packet.mapX[lane], packet.mapY[lane]), packet.isSide[lane], packet.steps[lane], &expected[lane], expectedStatus[lane]);
+				}
+			}
+		}
+	}
+	FreeMap(&gameMap);
+
+	char output[128];
+	snprintf(output, sizeof(output), "\n Traversals vs scalar walk: %d mismatches ( %d rays, open map edges and far planes )", mismatches, rays);
+	DebugOutput(output);
+	printf("%s \n", output + 2);
+	return mismatches;
+
+} // CheckTraversals()
+
+// Plain double DDA ( closed form side distances, as RayState ), the reference RAY_SCALAR builds are checked against
+Hit ReferenceRaycast(GameState *game, const GameMap *gameMap, Vec2 mapPos, Vec2 rayDir)
+{
+	Hit hit;
+	memset(&hit, 0, sizeof(hit) );
+
+	double deltaX	= sqrt(1 + square(rayDir.y) / square(rayDir.x));
+	double deltaY	= sqrt(1 + square(rayDir.x) / square(rayDir.y));
+	int mapX		= (int)mapPos.x;
+	int mapY		= (int)mapPos.y;
+	VecI2 mapStep	= { (rayDir.x < 0) ? -1 : 1, (rayDir.y < 0) ? -1 : 1 };
+	double startX	= (rayDir.x < 0) ? (mapPos.x - mapX) * deltaX : (mapX + 1.0 - mapPos.x) * deltaX;
+	double startY	= (rayDir.y < 0) ? (mapPos.y - mapY) * deltaY : (mapY + 1.0 - mapPos.y) * deltaY;
+	double sideX	= startX;
+	double sideY	= startY;
+	int stepsX		= 0;
+	int stepsY		= 0;
+	for (;;)
+	{
+		if (sideX < sideY)
+		{
+			sideX		= startX + ++stepsX * deltaX;
+			mapX		+= mapStep.x;
+			hit.isSide	= TRUE;
+		}
+		else
+		{
+			sideY		= startY + ++stepsY * deltaY;
+			mapY		+= mapStep.y;
+			hit.isSide	= FALSE;
+		}
+		if (!IsInsideMap(gameMap, mapX, mapY))
+		{
+			return hit;
+		}
+		if (GetTile(gameMap, mapX, mapY) > 0)
+		{
+			break;
+		}
+	}
+
+	hit.isHit	= TRUE;
+	hit.point	= vecI2(mapX, mapY);
+	hit.dist	= hit.isSide ? (mapX - mapPos.x + (1 - mapStep.x) / 2) / rayDir.x : (mapY - mapPos.y + (1 - mapStep.y) / 2) / rayDir.y;
+	hit.texX	= MirrorTexX(game, hit.isSide, rayDir, WallTexCoord(game, hit.isSide, rayDir, mapPos, mapX, mapY, hit.dist));
+	return hit;
+
+} // ReferenceRaycast()
+
+// Differential check of the RAY_SCALAR pipeline against the double reference: random rays through a fixed map of
+// scattered pillars, walled in, how often hit cell, side and texX agree. The first few rays that differ are written to
+// the debug output, returns 1 when more of them differ than RAY_SCALAR_TOLERANCE allows
+int CheckRayScalar(GameState *game)
+{
+	const int REPORTED		= 8;
+	const int SIZE			= 256;
+	const int RAYS			= 200000;
+	const double TWO_PI		= 6.283185307179586;
+	const int FAR_PLANE_ON	= game->debug.farPlane;
+	Uint32 random			= 0x2545F491; // the same map and rays on every run
+
+	GameMap gameMap;
+	memset(&gameMap, 0, sizeof(gameMap) );
+	if (!AllocateMapCells(&gameMap, SIZE, SIZE))
+	{
+		FreeMap(&gameMap);
+		return 1;
+	}
+	for (int i = 0; i < SIZE; i++)
+	{
+		SetTile(&gameMap, i, 0, 1);
+		SetTile(&gameMap, i, SIZE - 1, 1);
+		SetTile(&gameMap, 0, i, 1);
+		SetTile(&gameMap, SIZE - 1, i, 1);
+	}
+	for (int i = 0; i < SIZE * SIZE / 32; i++)
+	{
+		int x = NextRandom(&random) % SIZE;
+		SetTile(&gameMap, x, NextRandom(&random) % SIZE, 1);
+	}
+	BuildDistanceField(&gameMap.distanceField, &gameMap.occupancy);
+	game->debug.farPlane = FALSE; // the reference has none
+
+	int rays = 0, sameCell = 0, sameSide = 0, sameTexX = 0, nearTexX = 0, mismatches = 0;
+	while (rays < RAYS)
+	{
+		Vec2 mapPos		= vec2(NextRandom(&random) / 4294967296.0 * SIZE, NextRandom(&random) / 4294967296.0 * SIZE);
+		double angle	= NextRandom(&random) / 4294967296.0 * TWO_PI;
+		Vec2 rayDir		= vec2(cos(angle), sin(angle));
+		if (GetTile(&gameMap, (int)mapPos.x, (int)mapPos.y) > 0)
+		{
+			continue;
+		}
+		Hit expected	= ReferenceRaycast(game, &gameMap, mapPos, rayDir);
+
+		RayState ray;
+		InitRayState(&ray, mapPos, rayDir);
+		int status		= WalkRay(&ray, &gameMap, TRAVERSAL_SCALAR, NULL);
+		Hit hit;
+		memset(&hit, 0, sizeof(hit) );
+		hit.isSide		= ray.isSide;
+		hit.isHit		= (status == RAY_HIT);
+		if (hit.isHit)
+		{
+			ResolveHit(game, &hit, rayDir, mapPos, ray.mapStep, ray.mapX, ray.mapY, RayEndPos(game->player.pos, ray.steps, ray.mapStep));
+		}
+
+		int cellMatches	= hit.isHit == expected.isHit && hit.point.x == expected.point.x && hit.point.y == expected.point.y;
+		rays++;
+		sameCell		+= cellMatches;
+		sameSide		+= cellMatches && hit.isSide == expected.isSide;
+		sameTexX		+= cellMatches && hit.texX == expected.texX;
+		nearTexX		+= cellMatches && fabs(hit.texX - expected.texX) <= 1;
+		if (cellMatches && hit.isSide == expected.isSide && hit.texX == expected.texX)
+		{
+			continue;
+		}
+
+		if (mismatches++ < REPORTED)
+		{
+			char output[192];
+			snprintf(output, sizeof(output), "\n %s ray from ( %.3f, %.3f ) along ( %.4f, %.4f ): cell ( %d, %d ) side %d texX %.0f, double ( %d, %d ) side %d texX %.0f",
+				RAY_SCALAR_NAME, mapPos.x, mapPos.y, rayDir.x, rayDir.y, hit.point.x, hit.point.y, hit.isSide, hit.texX, expected.point.x, expected.point.y, expected.isSide, expected.texX);
+			DebugOutput(output);
+		}
+	}
+	game->debug.farPlane = FAR_PLANE_ON;
+	FreeMap(&gameMap);
+
+	const int ALLOWED = (int)(RAYS * RAY_SCALAR_TOLERANCE);
+	char output[256];
+	snprintf(output, sizeof(output), "\n %s rays vs double: cell %.3f%%, side %.3f%%, texX %.3f%% exact %.3f%% within 1 texel ( %d rays, %d mismatches, %d allowed )",
+		RAY_SCALAR_NAME, 100.0 * sameCell / rays, 100.0 * sameSide / rays, 100.0 * sameTexX / rays, 100.0 * nearTexX / rays, rays, mismatches, ALLOWED);
+	DebugOutput(output);
+	printf("%s \n", output + 2);
+	return mismatches > ALLOWED;
+
+} // CheckRayScalar()
+
+
+// Frees what LoadGame() and the window made, SDL stays initialized
+void UnloadGame( GameState* game )
+{
+	// Deallocate Resources
+	DestroyThreadPool(&game->threadPool);
+	FreeImage(&game->img_Checker);
+	FreeImage(&game->img_Wall);
+	FreeImage(&game->img_Floor);
+	FreeImage(&game->img_Hand);
+	FreeViewBuffers(game);
+	FreeWallSweep(&game->wallSweep);
+	FreeMap(&game->gameMap);
+
+	SDL_DestroyWindow(game->window);
+	SDL_DestroyRenderer(game->renderer);
+
+} // UnloadGame()
+
+int ExitGame( GameState* game )
+{
+	UnloadGame( game );
+	SDL_Quit();
+
+	return 0;
+
+} // ExitGame()
+
+void SetupGameState( GameState *game )
+{
+	memset( game, 0, sizeof *game );
+	game->window			= NULL;
+	game->renderer			= NULL;
+	game->renderScale		= 1.0;
+	game->debug				= (Debug) { FALSE, TRUE, FALSE, FALSE, TRUE, SOFTWARE_RENDER, TRAVERSAL, COALESCE_FACES, FRAME_CACHE, ADAPTIVE_COLUMNS, FAR_PLANE, MIPMAP_WALLS, FLOOR_CASTING, SPAN_COMPOSITION, PARALLEL_RASTER, DYNAMIC_RESOLUTION };
+
+} // SetupGameState()
+
+// "--headless [frames] [--size WxH] [--checksums file|none] [--frames prefix] [--verify-threads]",
+// "--batch poses [--size WxH] [--output file]", "--env instances [steps] [--size WxH] [--observe rgb|labels|columns]"
+// or "--bench-traversals" and "--check",
+// returns TRUE for any kind of headless run
+int ParseHeadlessOptions( int argc, char *argv[], HeadlessOptions* options )
+{
+	int isHeadless			= FALSE;
+	options->frameCount		= HEADLESS_FRAMES;
+	options->size			= (VecI2) { 0, 0 };
+	options->checksumPath	= HEADLESS_CHECKSUMS;
+	options->framePath		= NULL;
+	options->verifyThreads	= FALSE;
+	options->posePath		= NULL;
+	options->outputPath		= BATCH_OUTPUT;
+	options->envCount		= 0;
+	options->envSteps		= ENV_STEPS;
+	options->envObserve		= OBSERVE_RGB;
+	options->benchTraversals	= FALSE;
+	options->runChecks		= FALSE;
+
+	for ( int i = 1; i < argc; i++ )
+	{
+		const char* VALUE = ( i + 1 < argc ) ? argv[i + 1] : NULL;
+		if ( strcmp( argv[i], "--headless" ) == 0 )
+		{
+			isHeadless = TRUE;
+			if ( VALUE != NULL && atoi( VALUE ) > 0 )
+			{
+				options->frameCount = atoi( VALUE );
+				i++;
+			}
+		}
+		else if ( strcmp( argv[i], "--size" ) == 0 && VALUE != NULL )
+		{
+			VecI2 size;
+			if ( sscanf( VALUE, "%dx%d", &size.x, &size.y ) == 2 && size.x > 0 && size.y > 0 )
+			{
+				options->size = size;
+			}
+			i++;
+		}
+		else if ( strcmp( argv[i], "--checksums" ) == 0 && VALUE != NULL )
+		{
+			options->checksumPath = ( strcmp( VALUE, "none" ) == 0 ) ? NULL : VALUE;
+			i++;
+		}
+		else if ( strcmp( argv[i], "--frames" ) == 0 && VALUE != NULL )
+		{
+			options->framePath = VALUE;
+			i++;
+		}
+		else if ( strcmp( argv[i], "--verify-threads" ) == 0 )
+		{
+			options->verifyThreads = TRUE;
+		}
+		else if ( strcmp( argv[i], "--batch" ) == 0 && VALUE != NULL )
+		{
+			isHeadless			= TRUE;
+			options->posePath	= VALUE;
+			i++;
+		}
+		else if ( strcmp( argv[i], "--output" ) == 0 && VALUE != NULL )
+		{
+			options->outputPath = VALUE;
+			i++;
+		}
+		else if ( strcmp( argv[i], "--env" ) == 0 && VALUE != NULL && atoi( VALUE ) > 0 )
+		{
+			isHeadless			= TRUE;
+			options->envCount	= atoi( VALUE );
+			i++;
+			if ( i + 1 < argc && atoi( argv[i + 1] ) > 0 )
+			{
+				options->envSteps = atoi( argv[i + 1] );
+				i++;
+			}
+		}
+		else if ( strcmp( argv[i], "--bench-traversals" ) == 0 )
+		{
+			isHeadless					= TRUE;
+			options->benchTraversals	= TRUE;
+		}
+		else if ( strcmp( argv[i], "--check" ) == 0 )
+		{
+			isHeadless			= TRUE;
+			options->runChecks	= TRUE;
+		}
+		else if ( strcmp( argv[i], "--observe" ) == 0 && VALUE != NULL )
+		{
+			options->envObserve = ( strcmp( VALUE, "labels" ) == 0 ) ? OBSERVE_LABELS : ( strcmp( VALUE, "columns" ) == 0 ) ? 0 : OBSERVE_RGB;
+			i++;
+		}
+	}
+	return isHeadless;
+
+} // ParseHeadlessOptions()
+
+VecI2 HeadlessSize( const HeadlessOptions* options, VecI2 fallback )
+{
+	return ( options->size.x > 0 && options->size.y > 0 ) ? options->size : fallback;
+
+} // HeadlessSize()
+
+// FNV-1a over the pixels' RGB, alpha is left out since renderers disagree about it
+Uint64 ChecksumSurface( const SDL_Surface* surface )
+{
+	Uint64 hash = 14695981039346656037ull;
+	for ( int y = 0; y < surface->h; y++ )
+	{
+		const Uint32* row = (const Uint32*)( (const Uint8*)surface->pixels + (size_t)y * surface->pitch );
+		for ( int x = 0; x < surface->w; x++ )
+		{
+			hash = ( hash ^ ( row[x] & 0x00FFFFFF ) ) * 1099511628211ull;
+		}
+	}
+	return hash;
+
+} // ChecksumSurface()
+
+// Binary PPM of an ARGB8888 surface, rgbRow holds one row of packed RGB
+int WriteSurfacePPM( const SDL_Surface* surface, Uint8* rgbRow, const char* path )
+{
+	SDL_RWops* file = ( rgbRow != NULL ) ? SDL_RWFromFile( path, "wb" ) : NULL;
+	if ( file == NULL )
+	{
+		return FALSE;
+	}
+
+	char header[32];
+	const size_t HEADER_LENGTH	= snprintf( header, sizeof(header), "P6\n%d %d\n255\n", surface->w, surface->h );
+	const size_t ROW_LENGTH		= (size_t)surface->w * 3;
+	int isWritten				= SDL_RWwrite( file, header, 1, HEADER_LENGTH ) == HEADER_LENGTH;
+	for ( int y = 0; y < surface->h && isWritten; y++ )
+	{
+		const Uint32* row = (const Uint32*)( (const Uint8*)surface->pixels + (size_t)y * surface->pitch );
+		for ( int x = 0; x < surface->w; x++ )
+		{
+			rgbRow[x * 3 + 0] = (Uint8)( row[x] >> 16 );
+			rgbRow[x * 3 + 1] = (Uint8)( row[x] >> 8 );
+			rgbRow[x * 3 + 2] = (Uint8)row[x];
+		}
+		isWritten = SDL_RWwrite( file, rgbRow, 1, ROW_LENGTH ) == ROW_LENGTH;
+	}
+	SDL_RWclose( file );
+	return isWritten;
+
+} // WriteSurfacePPM()
+
+// No video subsystem: SDL's software renderer draws into the returned surface of size in memory, so no display server,
+// GPU or vsync is involved. Returns NULL when it cannot be created
+SDL_Surface* CreateOffscreenRenderer( GameState* game, VecI2 size )
+{
+	SDL_Surface* target	= SDL_CreateRGBSurfaceWithFormat( 0, size.x, size.y, 32, SDL_PIXELFORMAT_ARGB8888 );
+	game->renderer		= ( target != NULL ) ? SDL_CreateSoftwareRenderer( target ) : NULL;
+	if ( game->renderer == NULL )
+	{
+		printf("Cannot create the offscreen renderer! SDL Error: %s \n", SDL_GetError());
+		SDL_FreeSurface( target );
+		return NULL;
+	}
+	SDL_SetRenderDrawBlendMode(game->renderer, SDL_BLENDMODE_BLEND);
+	return target;
+
+} // CreateOffscreenRenderer()
+
+// Renders a scripted walk through the unchanged LoadGame() and DoRender() into an offscreen renderer. Every frame's
+// checksum and optionally the frame itself go to disk, the render time per frame to stdout
+int RunHeadless( GameState* game, const HeadlessOptions* options )
+{
+	SDL_Init( 0 );
+	RESOLUTION			= HeadlessSize( options, vecI2( SCREEN_WIDTH, SCREEN_HEIGHT ) );
+	SDL_Surface* target	= CreateOffscreenRenderer( game, RESOLUTION );
+	if ( target == NULL )
+	{
+		SDL_Quit();
+		return 1;
+	}
+
+	LoadGame( game, RESOLUTION );
+	Uint8* rgbRow = malloc( (size_t)RESOLUTION.x * 3 ); // a row of a written frame
+	game->debug.dynamicResolution = FALSE; // the governor follows the wall clock, frames must only depend on the walk
+
+	SDL_RWops* checksums = NULL;
+	if ( options->checksumPath != NULL && ( checksums = SDL_RWFromFile( options->checksumPath, "w" ) ) == NULL )
+	{
+		printf("Warning: Unable to open %s! SDL Error: %s \n", options->checksumPath, SDL_GetError());
+	}
+
+	// Walk forward while turning left, at a fixed time step
+	Uint8 keys[SDL_NUM_SCANCODES];
+	memset( keys, 0, sizeof(keys) );
+	keys[SDL_SCANCODE_W]	= TRUE;
+	keys[SDL_SCANCODE_LEFT]	= TRUE;
+	game->timer.deltaTime	= HEADLESS_STEP;
+
+	// Frames must not depend on the core count: with --verify-threads the pool gets at least VERIFY_THREADS workers,
+	// and each frame is rendered again with the pool serial
+	if ( options->verifyThreads && game->threadPool.threadCount < VERIFY_THREADS )
+	{
+		DestroyThreadPool( &game->threadPool );
+		CreateThreadPool( &game->threadPool, VERIFY_THREADS );
+	}
+	const int THREAD_COUNT	= game->threadPool.threadCount;
+	int threadMismatches	= 0;
+
+	Uint64 renderTime = 0;
+	for ( int frame = 0; frame < options->frameCount; frame++ )
+	{
+		game->timer.tickCurrent = frame * HEADLESS_STEP * 1000; // drives the hand bob
+		ProcessPlayerInput( keys, &game->player, &game->gameMap, game->timer.deltaTime );
+
+		Uint64 start = SDL_GetPerformanceCounter();
+		DoRender( game );
+		renderTime += SDL_GetPerformanceCounter() - start;
+
+		const Uint64 CHECKSUM = ChecksumSurface( target );
+		if ( checksums != NULL )
+		{
+			char line[48];
+			const size_t LENGTH = snprintf( line, sizeof(line), "%d %016" SDL_PRIx64 "\n", frame, CHECKSUM );
+			SDL_RWwrite( checksums, line, 1, LENGTH );
+		}
+		if ( options->framePath != NULL )
+		{
+			char path[512];
+			snprintf( path, sizeof(path), "%s%05d.ppm", options->framePath, frame );
+			if ( !WriteSurfacePPM( target, rgbRow, path ) )
+			{
+				printf("Warning: Unable to write %s! SDL Error: %s \n", path, SDL_GetError());
+			}
+		}
+
+		if ( options->verifyThreads )
+		{
+			SetThreadPoolSerial( &game->threadPool, TRUE );
+			memset( &game->frameKey, 0, sizeof(game->frameKey) ); // the same view again must not reuse the frame
+			DoRender( game );
+			SetThreadPoolSerial( &game->threadPool, FALSE );
+			if ( ChecksumSurface( target ) != CHECKSUM )
+			{
+				printf("Frame %d differs between %d threads and 1 \n", frame, THREAD_COUNT);
+				threadMismatches++;
+			}
+		}
+	}
+
+	const double MS = 1000.0 * renderTime / (double)SDL_GetPerformanceFrequency();
+	printf("Headless: %d frames at %dx%d, %.3f ms per frame ( %.1f FPS ) \n", options->frameCount, RESOLUTION.x, RESOLUTION.y,
+		MS / max( options->frameCount, 1 ), 1000.0 * options->frameCount / max( MS, 1e-9 ) );
+
+	if ( checksums != NULL )
+	{
+		SDL_RWclose( checksums );
+	}
+	if ( options->verifyThreads )
+	{
+		printf("Thread check: %d of %d frames differ between %d threads and 1 \n", threadMismatches, options->frameCount, THREAD_COUNT);
+	}
+	free( rgbRow );
+	ExitGame( game );
+	SDL_FreeSurface( target ); // the renderer drawing into it is gone
+	return threadMismatches > 0;
+
+} // RunHeadless()
+
+// Poses of a batch, one "x y dirX dirY [fov]" line each: position in map cells, view direction and horizontal field of
+// view in degrees, FOCAL_LENGTH's when left out. Lines starting with # are comments, invalid poses are skipped
+Pose* LoadPoses( const GameMap* gameMap, const char* path, int* poseCount )
+{
+	*poseCount = 0;
+	FILE* file = fopen( path, "r" );
+	if ( file == NULL )
+	{
+		printf("Cannot open pose file: %s \n\n", path );
+		return NULL;
+	}
+
+	Pose* poses		= NULL;
+	int capacity	= 0;
+	int line		= 0;
+	char text[256];
+	while ( fgets( text, sizeof(text), file ) != NULL )
+	{
+		line++;
+		Pose pose;
+		pose.fov	= 2 * atan( FOCAL_LENGTH ) * 180.0 / M_PI;
+		int fields	= sscanf( text, "%lf %lf %lf %lf %lf", &pose.pos.x, &pose.pos.y, &pose.direction.x, &pose.direction.y, &pose.fov );
+		if ( text[0] == '#' || fields == EOF ) // comments and blank lines
+		{
+			continue;
+		}
+		if ( fields < 4 || pose.pos.x < 0 || pose.pos.y < 0 || !IsInsideMap( gameMap, (int)pose.pos.x, (int)pose.pos.y ) ||
+			 ( pose.direction.x == 0 && pose.direction.y == 0 ) || !( pose.fov > 0 && pose.fov < 180 ) )
+		{
+			printf("Skipping invalid pose on line %d of %s \n", line, path );
+			continue;
+		}
+
+		if ( *poseCount == capacity )
+		{
+			capacity	= max( capacity * 2, 256 );
+			Pose* grown	= realloc( poses, sizeof(Pose) * capacity );
+			if ( grown == NULL )
+			{
+				printf("Cannot allocate %d poses \n\n", capacity );
+				free( poses );
+				fclose( file );
+				*poseCount = 0;
+				return NULL;
+			}
+			poses = grown;
+		}
+		poses[(*poseCount)++] = pose;
+	}
+	fclose( file );
+	return poses;
+
+} // LoadPoses()
+
+// Batch job: render poses [start, end) with the worker's view context and write each frame at its place in the stream
+void RenderPoseRange(void *context, int start, int end, int worker)
+{
+	BatchRender* batch	= (BatchRender*)context;
+	BatchWorker* self	= &batch->workers[worker];
+	GameState* view		= &self->view;
+	for (int i = start; i < end; i++)
+	{
+		const Pose* pose = &batch->poses[i];
+		SetPlayerView(&view->player, pose->pos, pose->direction, pose->fov);
+		RasterizeWorld(view);
+		PackFramebufferRGB(&view->frameBuffer, self->packed);
+		if (SDL_RWseek(self->output, (Sint64)i * batch->frameBytes, RW_SEEK_SET) < 0 ||
+			SDL_RWwrite(self->output, self->packed, 1, batch->frameBytes) != batch->frameBytes)
+		{
+			SDL_AtomicAdd(&batch->failures, 1);
+		}
+	}
+
+} // RenderPoseRange()
+
+// Renders every pose of the pose file with the game's own casting and rasterizing, spread over the thread pool with
+// a view context per worker. The stream holds one frame of width * height packed 8 bit RGB per pose, in pose order
+int RunBatch( GameState* game, const HeadlessOptions* options )
+{
+	SDL_Init( 0 );
+	RESOLUTION			= HeadlessSize( options, vecI2( SCREEN_WIDTH, SCREEN_HEIGHT ) );
+	SDL_Surface* target	= CreateOffscreenRenderer( game, RESOLUTION ); // textures are loaded through it
+	if ( target == NULL )
+	{
+		SDL_Quit();
+		return 1;
+	}
+	LoadGame( game, RESOLUTION );
+
+	BatchRender batch;
+	memset( &batch, 0, sizeof(batch) );
+	const int WORKERS	= max( game->threadPool.threadCount, 1 );
+	batch.poses			= LoadPoses( &game->gameMap, options->posePath, &batch.poseCount );
+	batch.frameBytes	= (size_t)RESOLUTION.x * RESOLUTION.y * 3;
+	batch.workers		= calloc( WORKERS, sizeof(BatchWorker) );
+
+	// Create the stream once, every worker then writes its frames in place through its own handle
+	SDL_RWops* output	= SDL_RWFromFile( options->outputPath, "wb" );
+	int isReady			= batch.poseCount > 0 && batch.workers != NULL && output != NULL;
+	if ( output != NULL )
+	{
+		SDL_RWclose( output );
+	}
+	for ( int i = 0; i < WORKERS && isReady; i++ )
+	{
+		BatchWorker* worker	= &batch.workers[i];
+		worker->packed		= malloc( batch.frameBytes );
+		worker->output		= SDL_RWFromFile( options->outputPath, "r+b" );
+		isReady				= CreateViewContext( &worker->view, game, RESOLUTION ) && worker->packed != NULL && worker->output != NULL;
+	}
+
+	if ( isReady )
+	{
+		Uint64 start		= SDL_GetPerformanceCounter();
+		RunThreadPool( &game->threadPool, RenderPoseRange, &batch, batch.poseCount, BATCH_CHUNK );
+		const double SECONDS	= ( SDL_GetPerformanceCounter() - start ) / (double)SDL_GetPerformanceFrequency();
+		const double FPS		= batch.poseCount / max( SECONDS, 1e-9 );
+		printf("Batch: %d poses at %dx%d RGB into %s, %.1f FPS on %d threads ( %.1f FPS per thread ) \n",
+			batch.poseCount, RESOLUTION.x, RESOLUTION.y, options->outputPath, FPS, WORKERS, FPS / WORKERS );
+		if ( SDL_AtomicGet( &batch.failures ) > 0 )
+		{
+			printf("Warning: %d frames could not be written! \n", SDL_AtomicGet( &batch.failures ) );
+		}
+	}
+	else
+	{
+		printf("Cannot set up the batch of %s into %s! SDL Error: %s \n", options->posePath, options->outputPath, SDL_GetError());
+	}
+
+	for ( int i = 0; batch.workers != NULL && i < WORKERS; i++ )
+	{
+		DestroyViewContext( &batch.workers[i].view );
+		free( batch.workers[i].packed );
+		if ( batch.workers[i].output != NULL )
+		{
+			SDL_RWclose( batch.workers[i].output );
+		}
+	}
+	const int FAILED = !isReady || SDL_AtomicGet( &batch.failures ) > 0;
+	free( batch.workers );
+	free( batch.poses );
+	ExitGame( game );
+	SDL_FreeSurface( target );
+	return FAILED;
+
+} // RunBatch()
+
+// Diagnostics without a window, for machines with no display: the game is loaded as for a headless run, then the
+// traversal benchmark and the self-checks run. Results go to stdout and the debug output, returns 1 when a check failed
+int RunDiagnostics( GameState* game, const HeadlessOptions* options )
+{
+	SDL_Init( 0 );
+	RESOLUTION			= HeadlessSize( options, vecI2( SCREEN_WIDTH, SCREEN_HEIGHT ) );
+	SDL_Surface* target	= CreateOffscreenRenderer( game, RESOLUTION ); // textures are loaded through it
+	if ( target == NULL )
+	{
+		SDL_Quit();
+		return 1;
+	}
+	LoadGame( game, RESOLUTION );
+
+	if ( options->benchTraversals )
+	{
+		BenchmarkTraversals( game );
+	}
+	int failed = FALSE;
+	if ( options->runChecks )
+	{
+		failed |= CheckTraversals() > 0;
+		failed |= CheckRayScalar( game );
+	}
+
+	ExitGame( game );
+	SDL_FreeSurface( target );
+	return failed;
+
+} // RunDiagnostics()
+
+// FNV-1a of hash continued over size bytes of data
+Uint64 HashBytes( Uint64 hash, const void* data, size_t size )
+{
+	for ( size_t i = 0; i < size; i++ )
+	{
+		hash = ( hash ^ ( (const Uint8*)data )[i] ) * 1099511628211ull;
+	}
+	return hash;
+
+} // HashBytes()
+
+// Steps an environment with random actions, prints the instance steps per second and a checksum of the last observations
+int RunEnvironment( const HeadlessOptions* options )
+{
+	SDL_Init( 0 ); // the environment leaves SDL to its host, which this run is
+	const VecI2 SIZE	= HeadlessSize( options, vecI2( ENV_WIDTH, ENV_HEIGHT ) );
+	EnvConfig config	= { options->envCount, SIZE.x, SIZE.y, options->envObserve, 1 };
+	VecEnv* env			= CreateVecEnv( &config );
+	int* actions		= malloc( sizeof(int) * config.instanceCount );
+	if ( env == NULL || actions == NULL )
+	{
+		DestroyVecEnv( env );
+		free( actions );
+		SDL_Quit();
+		return 1;
+	}
+
+	const EnvObservations* observations = ResetVecEnv( env );
+	Uint32 random		= 12345;
+	Uint64 start		= SDL_GetPerformanceCounter();
+	for ( int step = 0; step < options->envSteps; step++ )
+	{
+		for ( int i = 0; i < config.instanceCount; i++ )
+		{
+			actions[i] = NextRandom( &random ) % ACTION_COUNT;
+		}
+		observations = StepVecEnv( env, actions );
+	}
+	const double SECONDS	= ( SDL_GetPerformanceCounter() - start ) / (double)SDL_GetPerformanceFrequency();
+	const double RATE		= (double)options->envSteps * config.instanceCount / max( SECONDS, 1e-9 );
+
+	// Over every observation array, the padding between them is never written
+	const size_t PIXELS			= (size_t)config.instanceCount * config.width * config.height;
+	const ViewLabels* LABELS[]	= { &observations->columns, &observations->pixels };
+	const size_t COUNTS[]		= { (size_t)config.instanceCount * env->columnCount, ( observations->pixels.depth != NULL ) ? PIXELS : 0 };
+	Uint64 hash					= 14695981039346656037ull;
+	for ( int i = 0; i < 2; i++ )
+	{
+		hash = HashBytes( hash, LABELS[i]->depth, sizeof(float) * COUNTS[i] );
+		hash = HashBytes( hash, LABELS[i]->cell, sizeof(Sint32) * COUNTS[i] );
+		hash = HashBytes( hash, LABELS[i]->side, COUNTS[i] );
+		hash = HashBytes( hash, LABELS[i]->tile, COUNTS[i] );
+		hash = HashBytes( hash, LABELS[i]->surface, COUNTS[i] );
+	}
+	hash = HashBytes( hash, observations->rgb, ( observations->rgb != NULL ) ? PIXELS * 3 : 0 );
+
+	static const char* OBSERVED[] = { "column labels", "column labels and RGB", "column and pixel labels", "column and pixel labels and RGB" };
+	printf("Environment: %d instances of %dx%d, %s, %d steps, %.0f instance steps per second ( %.0f per thread ), checksum %016" SDL_PRIx64 " \n",
+		config.instanceCount, config.width, config.height, OBSERVED[config.observe & 3], options->envSteps, RATE, RATE / env->workerCount, hash );
+
+	free( actions );
+	DestroyVecEnv( env );
+	SDL_Quit();
+	return 0;
+
+} // RunEnvironment()
+
+int main(int argc, char *argv[])
+{
+	GameState game;
+	SetupGameState(&game);
+
+	HeadlessOptions headless;
+	if ( ParseHeadlessOptions( argc, argv, &headless ) )
+	{
+		if ( headless.envCount > 0 )
+		{
+			return RunEnvironment( &headless );
+		}
+		if ( headless.benchTraversals || headless.runChecks )
+		{
+			return RunDiagnostics( &game, &headless );
+		}
+		return ( headless.posePath != NULL ) ? RunBatch( &game, &headless ) : RunHeadless( &game, &headless );
+	}
+
+	// Setup Video
+	SDL_Init(SDL_INIT_VIDEO);
+	game.window = SDL_CreateWindow("RaycastEngine", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, RESOLUTION.x, RESOLUTION.y, SDL_WINDOW_RESIZABLE);
+	game.renderer = SDL_CreateRenderer(game.window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+	SDL_SetRenderDrawBlendMode(game.renderer, SDL_BLENDMODE_BLEND);
+	SDL_ShowCursor(SDL_DISABLE);
+
+	LoadGame(&game, RESOLUTION);
+
+	// Main Game Loop
+	int done = 0;
+	while ( !done )
+	{
+		UpdateTime(&game.timer);
+#if BENCHMARK
+		printf("Rays: %d \n", SDL_AtomicGet(&game.rayCount));
+		if (game.debug.softwareRender && !game.debug.displayMap) // the only path that counts every write
+		{
+			printf("Overdraw: %.2f writes per pixel \n", SDL_AtomicGet(&game.pixelWrites) / (double)( game.frameBuffer.width * game.frameBuffer.height ));
+		}
+#endif
+		done = ProcessInputsAndEvents( &game );
+		DoRender( &game );
+		done += Benchmark();
+	} // while
+
+	// Exit Game, Unload All Memory
+	return ExitGame( &game );
+
 } // main()
\ No newline at end of file
@@ -1,78 +1,208 @@
-#pragma once
-
-#include <stdio.h>
-#include <string.h>
-
-// Resource Paths
-#define CHECKER_PATH	"Resources/block.png"
-#define WALL_PATH		"Resources/concrete.png"
-#define HAND_PATH		"Resources/coffeehand.png"
-#define FLOOR_PATH		"Resources/floor.png"
-#define DEBUG_PATH		"Resources/debug_output.txt"
-
-// TODO: get map data from txt file
-
-#define MAP_SIZE		32
-#define SCREEN_WIDTH	1280
-#define SCREEN_HEIGHT	960
-
-// Global Enivornment Vars
-
-const double	FOCAL_LENGTH		= 0.75f;
-const VecI2		RESOLUTION			= { SCREEN_WIDTH, SCREEN_HEIGHT };
-const VecI2		GRID_RES			= { SCREEN_WIDTH / MAP_SIZE, SCREEN_HEIGHT / MAP_SIZE };
-
-typedef struct
-{
-	int		rayLength;
-	double	columnRatio;
-	double	wallScale;
-	double	darknessIntensity;
-	int		repeatWall;
-	int		map[MAP_SIZE][MAP_SIZE];
-
-} GameMap;
-
-// Create Game Map ( 0 = Space, 1 = Wall )
-int DemoMap[MAP_SIZE][MAP_SIZE] =
-{
-	{ 1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1 },
-	{ 1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,1,0,0,0,0,0,1 },
-	{ 1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,1,0,0,0,0,0,1 },
-	{ 1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,1,0,0,0,0,0,1 },
-	{ 1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,1,0,0,0,0,0,1 },
-	{ 1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,1,0,0,0,0,0,1 },
-	{ 1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1 },
-	{ 1,0,0,0,0,0,0,1,1,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1 },
-	{ 1,0,0,0,1,1,1,1,1,1,1,1,0,0,0,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1 },
-	{ 1,0,0,0,0,0,0,1,1,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1 },
-	{ 1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1 },
-	{ 1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1 },
-	{ 1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1 },
-	{ 1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1 },
-	{ 1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1 },
-	{ 1,1,1,1,1,1,1,0,0,1,1,1,1,1,1,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1 },
-	{ 1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1 },
-	{ 1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1 },
-	{ 1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1 },
-	{ 1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1 },
-	{ 1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1 },
-	{ 1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1 },
-	{ 1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1 },
-	{ 1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1 },
-	{ 1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1 },
-	{ 1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1 },
-	{ 1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1 },
-	{ 1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1 },
-	{ 1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1 },
-	{ 1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,0,0,0,0,1,1,1 },
-	{ 1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,0,0,0,1,1,1,1 },
-	{ 1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1 },
-};
-
-void InitializeMap( GameMap* gameMap, int rL, double cR, double wS, double dI, int rW )
-{
-	*gameMap = (GameMap) { rL, cR, wS, dI, rW };
-	memcpy( gameMap->map, DemoMap, sizeof(DemoMap));
-
-} // InitializeMap()
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Occupancy.h"
+#include "DistanceField.h"
+
+// Resource Paths
+#define CHECKER_PATH	"Resources/block.png"
+#define WALL_PATH		"Resources/concrete.png"
+#define HAND_PATH		"Resources/coffeehand.png"
+#define FLOOR_PATH		"Resources/floor.png"
+#define DEBUG_PATH		"Resources/debug_output.txt"
+#define MAP_PATH		"Resources/map.txt" // optional, DemoMap is used when missing
+
+#define DEMO_MAP_SIZE	32
+#define SCREEN_WIDTH	1280 // window size at startup, and the size of the world the demo map spans
+#define SCREEN_HEIGHT	960
+
+// Global Enivornment Vars
+
+const double	FOCAL_LENGTH		= 0.75f;
+VecI2			RESOLUTION			= { SCREEN_WIDTH, SCREEN_HEIGHT }; // output size in pixels, follows the window, see ResizeView()
+const VecI2		GRID_RES			= { SCREEN_WIDTH / DEMO_MAP_SIZE, SCREEN_HEIGHT / DEMO_MAP_SIZE }; // World units per map cell, independent of the output size
+
+// Map cells are stored in square chunks, Z-order ( Morton ) inside each chunk so 2D neighbours share cache lines
+#define MAP_CHUNK_BITS		4
+#define MAP_CHUNK_SIZE		( 1 << MAP_CHUNK_BITS )
+#define MAP_CHUNK_MASK		( MAP_CHUNK_SIZE - 1 )
+#define MAP_CHUNK_CELLS		( MAP_CHUNK_SIZE * MAP_CHUNK_SIZE )
+
+typedef Uint8 Tile; // 0 = Space, anything else = Wall
+
+// Low bits of a cell coordinate spread to the even bits of a Morton index
+const Uint8 MORTON_SPREAD[MAP_CHUNK_SIZE] = { 0x00, 0x01, 0x04, 0x05, 0x10, 0x11, 0x14, 0x15, 0x40, 0x41, 0x44, 0x45, 0x50, 0x51, 0x54, 0x55 };
+
+typedef struct
+{
+	int		rayLength;
+	double	columnRatio;
+	double	wallScale;
+	double	darknessIntensity;
+	int		repeatWall;
+
+	// Cell Storage
+	int		width, height; // in cells
+	int		chunksX, chunksY;
+	Tile*	tiles;
+	OccupancyGrid occupancy; // solid bits of the same cells
+	DistanceField distanceField; // empty space around each cell, for leaping
+	int		revision; // bumped by every SetTile(), so data derived from the cells can tell it is stale
+
+} GameMap;
+
+size_t TileIndex( const GameMap* gameMap, int x, int y )
+{
+	size_t chunk = (size_t)( y >> MAP_CHUNK_BITS ) * gameMap->chunksX + ( x >> MAP_CHUNK_BITS );
+	return ( chunk * MAP_CHUNK_CELLS ) | MORTON_SPREAD[x & MAP_CHUNK_MASK] | ( MORTON_SPREAD[y & MAP_CHUNK_MASK] << 1 );
+
+} // TileIndex()
+
+// Cell must be inside the map
+Tile GetTile( const GameMap* gameMap, int x, int y )
+{
+	return gameMap->tiles[ TileIndex( gameMap, x, y ) ];
+
+} // GetTile()
+
+void SetTile( GameMap* gameMap, int x, int y, Tile tile )
+{
+	gameMap->tiles[ TileIndex( gameMap, x, y ) ] = tile;
+	SetOccupied( &gameMap->occupancy, x, y, tile > 0 );
+	UpdateDistanceField( &gameMap->distanceField, &gameMap->occupancy, x, y );
+	gameMap->revision++;
+
+} // SetTile()
+
+int IsInsideMap( const GameMap* gameMap, int x, int y )
+{
+	return x >= 0 && y >= 0 && x < gameMap->width && y < gameMap->height;
+
+} // IsInsideMap()
+
+// Allocate empty cells for a width x height map, rounded up to whole chunks
+int AllocateMapCells( GameMap* gameMap, int width, int height )
+{
+	free( gameMap->tiles );
+	gameMap->width		= width;
+	gameMap->height		= height;
+	gameMap->chunksX	= ( width + MAP_CHUNK_MASK ) >> MAP_CHUNK_BITS;
+	gameMap->chunksY	= ( height + MAP_CHUNK_MASK ) >> MAP_CHUNK_BITS;
+	gameMap->tiles		= calloc( (size_t)gameMap->chunksX * gameMap->chunksY, MAP_CHUNK_CELLS * sizeof(Tile) );
+	return gameMap->tiles != NULL && AllocateOccupancy( &gameMap->occupancy, width, height ) && AllocateDistanceField( &gameMap->distanceField, width, height );
+
+} // AllocateMapCells()
+
+void FreeMap( GameMap* gameMap )
+{
+	free( gameMap->tiles );
+	FreeOccupancy( &gameMap->occupancy );
+	FreeDistanceField( &gameMap->distanceField );
+	gameMap->tiles	= NULL;
+	gameMap->width	= 0;
+	gameMap->height	= 0;
+
+} // FreeMap()
+
+// Text map: "width height" followed by width * height cell values ( 0 = Space )
+int LoadMapFile( GameMap* gameMap, const char* path )
+{
+	FILE* file = fopen( path, "r" );
+	if ( file == NULL )
+	{
+		return FALSE;
+	}
+
+	int width = 0, height = 0;
+	if ( fscanf( file, "%d %d", &width, &height ) != 2 || width <= 0 || height <= 0 || !AllocateMapCells( gameMap, width, height ) )
+	{
+		printf("Invalid map file: %s \n\n", path );
+		fclose( file );
+		return FALSE;
+	}
+
+	for ( int y = 0; y < height; y++ )
+	{
+		for ( int x = 0; x < width; x++ )
+		{
+			int cell = 0;
+			if ( fscanf( file, "%d", &cell ) != 1 )
+			{
+				printf("Map file ended early: %s \n\n", path );
+				fclose( file );
+				return FALSE;
+			}
+			SetTile( gameMap, x, y, (Tile)clampI( cell, 0, 255 ) );
+		}
+	}
+	fclose( file );
+	return TRUE;
+
+} // LoadMapFile()
+
+// Create Game Map ( 0 = Space, 1 = Wall )
+int DemoMap[DEMO_MAP_SIZE][DEMO_MAP_SIZE] =
+{
+	{ 1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1 },
+	{ 1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,1,0,0,0,0,0,1 },
+	{ 1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,1,0,0,0,0,0,1 },
+	{ 1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,1,0,0,0,0,0,1 },
+	{ 1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,1,0,0,0,0,0,1 },
+	{ 1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,1,0,0,0,0,0,1 },
+	{ 1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1 },
+	{ 1,0,0,0,0,0,0,1,1,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1 },
+	{ 1,0,0,0,1,1,1,1,1,1,1,1,0,0,0,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1 },
+	{ 1,0,0,0,0,0,0,1,1,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1 },
+	{ 1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1 },
+	{ 1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1 },
+	{ 1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1 },
+	{ 1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1 },
+	{ 1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1 },
+	{ 1,1,1,1,1,1,1,0,0,1,1,1,1,1,1,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1 },
+	{ 1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1 },
+	{ 1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1 },
+	{ 1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1 },
+	{ 1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1 },
+	{ 1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1 },
+	{ 1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1 },
+	{ 1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1 },
+	{ 1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1 },
+	{ 1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1 },
+	{ 1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1 },
+	{ 1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1 },
+	{ 1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1 },
+	{ 1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1 },
+	{ 1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,0,0,0,0,1,1,1 },
+	{ 1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,0,0,0,0,0,0,0,0,0,0,0,1,1,1,1 },
+	{ 1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1 },
+};
+
+void InitializeMap( GameMap* gameMap, int rL, double cR, double wS, double dI, int rW )
+{
+	int revision = gameMap->revision; // keeps counting up across maps
+	FreeMap( gameMap );
+	*gameMap = (GameMap) { rL, cR, wS, dI, rW };
+	gameMap->revision = revision + 1;
+
+	if ( LoadMapFile( gameMap, MAP_PATH ) )
+	{
+		BuildDistanceField( &gameMap->distanceField, &gameMap->occupancy );
+		return;
+	}
+	if ( !AllocateMapCells( gameMap, DEMO_MAP_SIZE, DEMO_MAP_SIZE ) )
+	{
+		printf("Cannot allocate map \n\n");
+		exit(1);
+	}
+	for ( int y = 0; y < DEMO_MAP_SIZE; y++ )
+	{
+		for ( int x = 0; x < DEMO_MAP_SIZE; x++ )
+		{
+			SetTile( gameMap, x, y, (Tile)DemoMap[y][x] );
+		}
+	}
+	BuildDistanceField( &gameMap->distanceField, &gameMap->occupancy );
+
+} // InitializeMap()
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <stdlib.h>
+#include <string.h>
+#include "SDL.h"
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// 1 bit per map cell, kept both by rows and by columns so runs along either axis are a few word scans
+typedef struct
+{
+	int		width, height; // in cells
+	int		rowWords; // Uint64 words per row
+	int		columnWords; // Uint64 words per column
+	Uint64*	rows;
+	Uint64*	columns;
+
+} OccupancyGrid;
+
+int LowestBit64( Uint64 bits )
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	if ( _BitScanForward( &index, (unsigned long)bits ) )
+	{
+		return (int)index;
+	}
+	_BitScanForward( &index, (unsigned long)( bits >> 32 ) );
+	return (int)index + 32;
+#else
+	return __builtin_ctzll( bits );
+#endif
+
+} // LowestBit64()
+
+int HighestBit64( Uint64 bits )
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	if ( _BitScanReverse( &index, (unsigned long)( bits >> 32 ) ) )
+	{
+		return (int)index + 32;
+	}
+	_BitScanReverse( &index, (unsigned long)bits );
+	return (int)index;
+#else
+	return 63 - __builtin_clzll( bits );
+#endif
+
+} // HighestBit64()
+
+int AllocateOccupancy( OccupancyGrid* grid, int width, int height )
+{
+	free( grid->rows );
+	free( grid->columns );
+	grid->width			= width;
+	grid->height		= height;
+	grid->rowWords		= ( width + 63 ) / 64;
+	grid->columnWords	= ( height + 63 ) / 64;
+	grid->rows			= calloc( (size_t)grid->rowWords * height, sizeof(Uint64) );
+	grid->columns		= calloc( (size_t)grid->columnWords * width, sizeof(Uint64) );
+	return grid->rows != NULL && grid->columns != NULL;
+
+} // AllocateOccupancy()
+
+void FreeOccupancy( OccupancyGrid* grid )
+{
+	free( grid->rows );
+	free( grid->columns );
+	memset( grid, 0, sizeof *grid );
+
+} // FreeOccupancy()
+
+void SetOccupied( OccupancyGrid* grid, int x, int y, int isSolid )
+{
+	Uint64* rowWord		= &grid->rows[ (size_t)y * grid->rowWords + ( x >> 6 ) ];
+	Uint64* columnWord	= &grid->columns[ (size_t)x * grid->columnWords + ( y >> 6 ) ];
+	Uint64 rowBit		= (Uint64)1 << ( x & 63 );
+	Uint64 columnBit	= (Uint64)1 << ( y & 63 );
+
+	*rowWord			= isSolid ? ( *rowWord | rowBit ) : ( *rowWord & ~rowBit );
+	*columnWord			= isSolid ? ( *columnWord | columnBit ) : ( *columnWord & ~columnBit );
+
+} // SetOccupied()
+
+// Cell must be inside the grid
+int IsOccupied( const OccupancyGrid* grid, int x, int y )
+{
+	return ( grid->rows[ (size_t)y * grid->rowWords + ( x >> 6 ) ] >> ( x & 63 ) ) & 1;
+
+} // IsOccupied()
+
+// First set bit walking from 'from' towards 'to' ( either direction, both inclusive and in range ), -1 if none
+int FindFirstBit( const Uint64* words, int from, int to )
+{
+	if ( from <= to )
+	{
+		int word		= from >> 6;
+		Uint64 bits		= words[word] & ( ~(Uint64)0 << ( from & 63 ) );
+		const int LAST	= to >> 6;
+		for ( ;; )
+		{
+			if ( bits != 0 )
+			{
+				int index = ( word << 6 ) + LowestBit64( bits );
+				return ( index <= to ) ? index : -1;
+			}
+			if ( ++word > LAST )
+			{
+				return -1;
+			}
+			bits = words[word];
+		}
+	}
+
+	int word		= from >> 6;
+	Uint64 bits		= words[word] & ( ~(Uint64)0 >> ( 63 - ( from & 63 ) ) );
+	const int LAST	= to >> 6;
+	for ( ;; )
+	{
+		if ( bits != 0 )
+		{
+			int index = ( word << 6 ) + HighestBit64( bits );
+			return ( index >= to ) ? index : -1;
+		}
+		if ( --word < LAST )
+		{
+			return -1;
+		}
+		bits = words[word];
+	}
+
+} // FindFirstBit()
+
+// First solid x in row y between fromX and toX, -1 if the span is empty
+int FindSolidInRow( const OccupancyGrid* grid, int y, int fromX, int toX )
+{
+	return FindFirstBit( grid->rows + (size_t)y * grid->rowWords, fromX, toX );
+
+} // FindSolidInRow()
+
+// First solid y in column x between fromY and toY, -1 if the span is empty
+int FindSolidInColumn( const OccupancyGrid* grid, int x, int fromY, int toY )
+{
+	return FindFirstBit( grid->columns + (size_t)x * grid->columnWords, fromY, toY );
+
+} // FindSolidInColumn()
@@ -0,0 +1,278 @@
+#pragma once
+
+#include <emmintrin.h>
+#if defined(__AVX2__) || defined(__AVX__)
+#include <immintrin.h>
+#endif
+#include "Map.h"
+#include "RayTraversal.h"
+
+// Lanes of a PacketD, the packets ColumnRays are computed in
+#define DOUBLE_LANES		4
+
+// Columns traversed together by one packet, twice as many float lanes fit the same registers as double ones
+#if RAY_SCALAR == RAY_SCALAR_FLOAT
+#define RAY_PACKET_SIZE		8
+#else
+#define RAY_PACKET_SIZE		DOUBLE_LANES
+#endif
+
+// 4 double lanes: one AVX register, or a pair of SSE2 registers
+#if defined(__AVX2__) || defined(__AVX__)
+
+typedef __m256d PacketD;
+
+#define PacketLoad( p )			_mm256_load_pd( p )
+#define PacketStore( p, a )		_mm256_store_pd( p, a )
+#define PacketSet1( x )			_mm256_set1_pd( x )
+#define PacketAdd( a, b )		_mm256_add_pd( a, b )
+#define PacketSub( a, b )		_mm256_sub_pd( a, b )
+#define PacketMul( a, b )		_mm256_mul_pd( a, b )
+#define PacketDiv( a, b )		_mm256_div_pd( a, b )
+#define PacketSqrt( a )			_mm256_sqrt_pd( a )
+#define PacketAnd( a, b )		_mm256_and_pd( a, b )
+#define PacketAndNot( m, a )	_mm256_andnot_pd( m, a )
+#define PacketMin( a, b )		_mm256_min_pd( a, b )
+#if defined(__FMA__) || ( defined(_MSC_VER) && defined(__AVX2__) )
+#define PacketFma( a, b, c )	_mm256_fmadd_pd( a, b, c )
+#else
+#define PacketFma( a, b, c )	_mm256_add_pd( _mm256_mul_pd( a, b ), c )
+#endif
+#define PacketLess( a, b )		_mm256_cmp_pd( a, b, _CMP_LT_OQ )
+#define PacketMask( a )			_mm256_movemask_pd( a )
+#define PacketSelect( m, a, b )	_mm256_blendv_pd( b, a, m )
+
+#else
+
+typedef struct
+{
+	__m128d lo, hi;
+
+} PacketD;
+
+PacketD PacketPair( __m128d lo, __m128d hi )
+{
+	PacketD packet = { lo, hi };
+	return packet;
+
+} // PacketPair()
+
+#define PacketLoad( p )			PacketPair( _mm_load_pd( p ), _mm_load_pd( (p) + 2 ) )
+#define PacketStore( p, a )		( _mm_store_pd( p, (a).lo ), _mm_store_pd( (p) + 2, (a).hi ) )
+#define PacketSet1( x )			PacketPair( _mm_set1_pd( x ), _mm_set1_pd( x ) )
+#define PacketAdd( a, b )		PacketPair( _mm_add_pd( (a).lo, (b).lo ), _mm_add_pd( (a).hi, (b).hi ) )
+#define PacketSub( a, b )		PacketPair( _mm_sub_pd( (a).lo, (b).lo ), _mm_sub_pd( (a).hi, (b).hi ) )
+#define PacketMul( a, b )		PacketPair( _mm_mul_pd( (a).lo, (b).lo ), _mm_mul_pd( (a).hi, (b).hi ) )
+#define PacketDiv( a, b )		PacketPair( _mm_div_pd( (a).lo, (b).lo ), _mm_div_pd( (a).hi, (b).hi ) )
+#define PacketSqrt( a )			PacketPair( _mm_sqrt_pd( (a).lo ), _mm_sqrt_pd( (a).hi ) )
+#define PacketAnd( a, b )		PacketPair( _mm_and_pd( (a).lo, (b).lo ), _mm_and_pd( (a).hi, (b).hi ) )
+#define PacketAndNot( m, a )	PacketPair( _mm_andnot_pd( (m).lo, (a).lo ), _mm_andnot_pd( (m).hi, (a).hi ) )
+#define PacketMin( a, b )		PacketPair( _mm_min_pd( (a).lo, (b).lo ), _mm_min_pd( (a).hi, (b).hi ) )
+#define PacketFma( a, b, c )	PacketAdd( PacketMul( a, b ), c )
+#define PacketLess( a, b )		PacketPair( _mm_cmplt_pd( (a).lo, (b).lo ), _mm_cmplt_pd( (a).hi, (b).hi ) )
+#define PacketMask( a )			( _mm_movemask_pd( (a).lo ) | ( _mm_movemask_pd( (a).hi ) << 2 ) )
+#define PacketSelect( m, a, b )	PacketPair( _mm_or_pd( _mm_and_pd( (m).lo, (a).lo ), _mm_andnot_pd( (m).lo, (b).lo ) ), \
+											_mm_or_pd( _mm_and_pd( (m).hi, (a).hi ), _mm_andnot_pd( (m).hi, (b).hi ) ) )
+
+#endif
+
+// Lanes of the traversal kernel, in the ray pipeline's number type so every lane walks exactly like a RayState.
+// Fixed point has no packet kernel, saturating 16.16 products do not fit SIMD lanes, so its packets keep double
+// lanes that its scalar walk does not match ( see IS_PACKET_EXACT )
+#if RAY_SCALAR == RAY_SCALAR_FLOAT
+
+typedef float PacketScalar;
+
+// 8 float lanes: one AVX register, or a pair of SSE registers
+#if defined(__AVX2__) || defined(__AVX__)
+
+typedef __m256 PacketLanes;
+
+#define LanesLoad( p )			_mm256_load_ps( p )
+#define LanesSet1( x )			_mm256_set1_ps( x )
+#define LanesAdd( a, b )		_mm256_add_ps( a, b )
+#define LanesMul( a, b )		_mm256_mul_ps( a, b )
+#define LanesAnd( a, b )		_mm256_and_ps( a, b )
+#define LanesAndNot( m, a )		_mm256_andnot_ps( m, a )
+#define LanesMin( a, b )		_mm256_min_ps( a, b )
+#define LanesLess( a, b )		_mm256_cmp_ps( a, b, _CMP_LT_OQ )
+#define LanesMask( a )			_mm256_movemask_ps( a )
+#define LanesSelect( m, a, b )	_mm256_blendv_ps( b, a, m )
+
+#else
+
+typedef struct
+{
+	__m128 lo, hi;
+
+} PacketLanes;
+
+PacketLanes LanesPair( __m128 lo, __m128 hi )
+{
+	PacketLanes packet = { lo, hi };
+	return packet;
+
+} // LanesPair()
+
+#define LanesLoad( p )			LanesPair( _mm_load_ps( p ), _mm_load_ps( (p) + 4 ) )
+#define LanesSet1( x )			LanesPair( _mm_set1_ps( x ), _mm_set1_ps( x ) )
+#define LanesAdd( a, b )		LanesPair( _mm_add_ps( (a).lo, (b).lo ), _mm_add_ps( (a).hi, (b).hi ) )
+#define LanesMul( a, b )		LanesPair( _mm_mul_ps( (a).lo, (b).lo ), _mm_mul_ps( (a).hi, (b).hi ) )
+#define LanesAnd( a, b )		LanesPair( _mm_and_ps( (a).lo, (b).lo ), _mm_and_ps( (a).hi, (b).hi ) )
+#define LanesAndNot( m, a )		LanesPair( _mm_andnot_ps( (m).lo, (a).lo ), _mm_andnot_ps( (m).hi, (a).hi ) )
+#define LanesMin( a, b )		LanesPair( _mm_min_ps( (a).lo, (b).lo ), _mm_min_ps( (a).hi, (b).hi ) )
+#define LanesLess( a, b )		LanesPair( _mm_cmplt_ps( (a).lo, (b).lo ), _mm_cmplt_ps( (a).hi, (b).hi ) )
+#define LanesMask( a )			( _mm_movemask_ps( (a).lo ) | ( _mm_movemask_ps( (a).hi ) << 4 ) )
+#define LanesSelect( m, a, b )	LanesPair( _mm_or_ps( _mm_and_ps( (m).lo, (a).lo ), _mm_andnot_ps( (m).lo, (b).lo ) ), \
+											_mm_or_ps( _mm_and_ps( (m).hi, (a).hi ), _mm_andnot_ps( (m).hi, (b).hi ) ) )
+
+#endif
+
+#else
+
+typedef double	PacketScalar;
+typedef PacketD	PacketLanes;
+
+#define LanesLoad( p )			PacketLoad( p )
+#define LanesSet1( x )			PacketSet1( x )
+#define LanesAdd( a, b )		PacketAdd( a, b )
+#define LanesMul( a, b )		PacketMul( a, b )
+#define LanesAnd( a, b )		PacketAnd( a, b )
+#define LanesAndNot( m, a )		PacketAndNot( m, a )
+#define LanesMin( a, b )		PacketMin( a, b )
+#define LanesLess( a, b )		PacketLess( a, b )
+#define LanesMask( a )			PacketMask( a )
+#define LanesSelect( m, a, b )	PacketSelect( m, a, b )
+
+#endif
+
+#define IS_PACKET_EXACT			( RAY_SCALAR != RAY_SCALAR_FIXED ) // packet lanes end in the same state as WalkRay()
+
+// DDA state of RAY_PACKET_SIZE rays sharing one start position
+typedef struct
+{
+	// Inputs, in double as ColumnRays holds them, TraversePacket() converts them to its lanes
+	ALIGNED(32) double rayDirX[RAY_PACKET_SIZE];
+	ALIGNED(32) double rayDirY[RAY_PACKET_SIZE];
+	ALIGNED(32) double deltaDistX[RAY_PACKET_SIZE]; // as RayState.deltaDist
+	ALIGNED(32) double deltaDistY[RAY_PACKET_SIZE];
+	ALIGNED(32) double farDist[RAY_PACKET_SIZE]; // as RayState.farDist
+	Vec2	mapPos;
+	Vec2	startPos;
+
+	// Per lane results, valid for lanes that finished
+	int		mapX[RAY_PACKET_SIZE];
+	int		mapY[RAY_PACKET_SIZE];
+	VecI2	mapStep[RAY_PACKET_SIZE];
+	VecI2	steps[RAY_PACKET_SIZE];
+	int		isSide[RAY_PACKET_SIZE];
+	int		isHit[RAY_PACKET_SIZE];
+	int		isFar[RAY_PACKET_SIZE]; // stopped at the far plane
+
+} RayPacket;
+
+// Same operations, in the same order and number type, as InitRayStateDelta() and StepRay() so every lane matches them bit for bit
+void TraversePacket( const GameMap* gameMap, RayPacket* packet, int laneCount )
+{
+	ALIGNED(32) PacketScalar deltaLanesX[RAY_PACKET_SIZE];
+	ALIGNED(32) PacketScalar deltaLanesY[RAY_PACKET_SIZE];
+	ALIGNED(32) PacketScalar startLanesX[RAY_PACKET_SIZE];
+	ALIGNED(32) PacketScalar startLanesY[RAY_PACKET_SIZE];
+	ALIGNED(32) PacketScalar farLanes[RAY_PACKET_SIZE];
+
+	int mapX = (int)packet->mapPos.x;
+	int mapY = (int)packet->mapPos.y;
+
+	//calculate step and initial sideDist, lane by lane as InitRayStateDelta() does
+	const PacketScalar BEHIND_X	= (PacketScalar)( packet->mapPos.x - mapX );
+	const PacketScalar AHEAD_X	= (PacketScalar)( mapX + 1.0 - packet->mapPos.x );
+	const PacketScalar BEHIND_Y	= (PacketScalar)( packet->mapPos.y - mapY );
+	const PacketScalar AHEAD_Y	= (PacketScalar)( mapY + 1.0 - packet->mapPos.y );
+	for ( int lane = 0; lane < RAY_PACKET_SIZE; lane++ )
+	{
+		const int NEGATIVE_X	= packet->rayDirX[lane] < 0;
+		const int NEGATIVE_Y	= packet->rayDirY[lane] < 0;
+		deltaLanesX[lane]		= (PacketScalar)packet->deltaDistX[lane];
+		deltaLanesY[lane]		= (PacketScalar)packet->deltaDistY[lane];
+		startLanesX[lane]		= ( NEGATIVE_X ? BEHIND_X : AHEAD_X ) * deltaLanesX[lane];
+		startLanesY[lane]		= ( NEGATIVE_Y ? BEHIND_Y : AHEAD_Y ) * deltaLanesY[lane];
+		farLanes[lane]			= (PacketScalar)packet->farDist[lane];
+
+		packet->mapX[lane]		= mapX;
+		packet->mapY[lane]		= mapY;
+		packet->mapStep[lane]	= vecI2( NEGATIVE_X ? -1 : 1, NEGATIVE_Y ? -1 : 1 );
+		packet->steps[lane]		= vecI2( 0, 0 );
+		packet->isSide[lane]	= FALSE;
+		packet->isHit[lane]		= FALSE;
+		packet->isFar[lane]		= FALSE;
+	}
+
+	const PacketLanes ONE		= LanesSet1( 1 );
+	PacketLanes deltaDistX		= LanesLoad( deltaLanesX );
+	PacketLanes deltaDistY		= LanesLoad( deltaLanesY );
+	PacketLanes sideStartX		= LanesLoad( startLanesX );
+	PacketLanes sideStartY		= LanesLoad( startLanesY );
+	PacketLanes sideDistX		= sideStartX;
+	PacketLanes sideDistY		= sideStartY;
+	PacketLanes stepsX			= LanesSet1( 0 );
+	PacketLanes stepsY			= LanesSet1( 0 );
+	PacketLanes farDist			= LanesLoad( farLanes );
+	int active					= ( 1 << laneCount ) - 1;
+
+	//perform DDA, lanes that have hit, left the map or reached the far plane drop out of the active mask
+	while ( active )
+	{
+		int farMask = LanesMask( LanesLess( farDist, LanesMin( sideDistX, sideDistY ) ) ) & active;
+		for ( int lane = 0; farMask != 0 && lane < laneCount; lane++ )
+		{
+			packet->isFar[lane] |= farMask >> lane & 1;
+		}
+		active &= ~farMask;
+
+		//jump to next map square, OR in x-direction, OR in y-direction ( side distances in closed form, see RayState )
+		PacketLanes stepX	= LanesLess( sideDistX, sideDistY );
+		stepsX				= LanesAdd( stepsX, LanesAnd( stepX, ONE ) );
+		stepsY				= LanesAdd( stepsY, LanesAndNot( stepX, ONE ) );
+		sideDistX			= LanesSelect( stepX, LanesAdd( sideStartX, LanesMul( stepsX, deltaDistX ) ), sideDistX );
+		sideDistY			= LanesSelect( stepX, sideDistY, LanesAdd( sideStartY, LanesMul( stepsY, deltaDistY ) ) );
+		int stepMask		= LanesMask( stepX );
+
+		for ( int lane = 0; lane < laneCount; lane++ )
+		{
+			if ( ( active >> lane & 1 ) == 0 )
+			{
+				continue;
+			}
+
+			if ( stepMask >> lane & 1 )
+			{
+				packet->mapX[lane]			+= packet->mapStep[lane].x;
+				packet->steps[lane].x++;
+				packet->isSide[lane]		 = TRUE;
+			}
+			else
+			{
+				packet->mapY[lane]			+= packet->mapStep[lane].y;
+				packet->steps[lane].y++;
+				packet->isSide[lane]		 = FALSE;
+			}
+
+			int xOut = (packet->mapX[lane] < 0 || packet->mapX[lane] > gameMap->width - 1);
+			int yOut = (packet->mapY[lane] < 0 || packet->mapY[lane] > gameMap->height - 1);
+			if (xOut || yOut)
+			{
+				active &= ~( 1 << lane );
+				continue;
+			}
+
+			//Check if ray has hit a wall
+			if ( GetTile( gameMap, packet->mapX[lane], packet->mapY[lane] ) > 0 )
+			{
+				packet->isHit[lane] = TRUE;
+				active &= ~( 1 << lane );
+			}
+		}
+
+	} // while
+
+} // TraversePacket()
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <math.h>
+#include "SDL.h"
+#include "CustomMath.h"
+
+// Number type of the ray traversal ( DDA side distances, crossings and the far plane, in the scalar walk and the packet
+// lanes ), picked by a single build switch. Hits are resolved in double from the cell and side the traversal found.
+// Define RAY_SCALAR in the project's preprocessor definitions to override the default. RAY_SCALAR_TOLERANCE is the
+// fraction of CheckRayScalar()'s rays whose cell, side or texX may differ from the double reference; the error grows
+// with ray length, so it only holds for that map
+#define RAY_SCALAR_DOUBLE	0
+#define RAY_SCALAR_FLOAT	1
+#define RAY_SCALAR_FIXED	2 // 16.16 fixed point, saturating instead of overflowing
+
+#ifndef RAY_SCALAR
+#define RAY_SCALAR			RAY_SCALAR_DOUBLE
+#endif
+
+#if RAY_SCALAR == RAY_SCALAR_FIXED
+typedef Sint32 RayScalar;
+#define RAY_FIXED_ONE		65536
+#define RAY_FIXED_MAX		0x7FFFFFFF // stands in for infinity
+#define RAY_FIXED_MIN		( -RAY_FIXED_MAX - 1 )
+#define RAY_SCALAR_MAX		RAY_FIXED_MAX
+#define RAY_SCALAR_NAME		"16.16 fixed"
+#define RAY_SCALAR_TOLERANCE	0.0005 // 10 in 200000 measured: crossings rounded to 1/65536 of a cell pick the other side
+#elif RAY_SCALAR == RAY_SCALAR_FLOAT
+typedef float RayScalar;
+#define RAY_SCALAR_MAX		INFINITY
+#define RAY_SCALAR_NAME		"float"
+#define RAY_SCALAR_TOLERANCE	0.0001 // none measured, left for compilers that contract or keep float in wider registers
+#else
+typedef double RayScalar;
+#define RAY_SCALAR_MAX		INFINITY
+#define RAY_SCALAR_NAME		"double"
+#define RAY_SCALAR_TOLERANCE	0.0 // the reference's own algorithm, any difference is a bug
+#endif
+
+typedef struct
+{
+	RayScalar x, y;
+} RayVec2;
+
+#if RAY_SCALAR == RAY_SCALAR_FIXED
+RayScalar RaySaturate( Sint64 x )
+{
+	return (RayScalar)( ( x > RAY_FIXED_MAX ) ? RAY_FIXED_MAX : ( x < RAY_FIXED_MIN ) ? RAY_FIXED_MIN : x );
+
+} // RaySaturate()
+#endif
+
+RayScalar RayFromDouble( double x )
+{
+#if RAY_SCALAR == RAY_SCALAR_FIXED
+	x *= RAY_FIXED_ONE;
+	if ( isnan( x ) || x >= RAY_FIXED_MAX )
+	{
+		return RAY_FIXED_MAX;
+	}
+	return ( x <= RAY_FIXED_MIN ) ? RAY_FIXED_MIN : (RayScalar)x;
+#else
+	return (RayScalar)x;
+#endif
+
+} // RayFromDouble()
+
+double RayToDouble( RayScalar x )
+{
+#if RAY_SCALAR == RAY_SCALAR_FIXED
+	return x / (double)RAY_FIXED_ONE;
+#else
+	return x;
+#endif
+
+} // RayToDouble()
+
+RayVec2 RayVec2FromDouble( Vec2 v )
+{
+	RayVec2 result = { RayFromDouble( v.x ), RayFromDouble( v.y ) };
+	return result;
+
+} // RayVec2FromDouble()
+
+RayScalar RayAdd( RayScalar a, RayScalar b )
+{
+#if RAY_SCALAR == RAY_SCALAR_FIXED
+	return RaySaturate( (Sint64)a + b );
+#else
+	return a + b;
+#endif
+
+} // RayAdd()
+
+RayScalar RayMul( RayScalar a, RayScalar b )
+{
+#if RAY_SCALAR == RAY_SCALAR_FIXED
+	return RaySaturate( ( (Sint64)a * b ) / RAY_FIXED_ONE );
+#else
+	return a * b;
+#endif
+
+} // RayMul()
+
+RayScalar RayMulInt( RayScalar a, int n )
+{
+#if RAY_SCALAR == RAY_SCALAR_FIXED
+	return RaySaturate( (Sint64)a * n );
+#else
+	return n * a;
+#endif
+
+} // RayMulInt()
+
+// Saturated fixed point values count as infinite
+int RayIsFinite( RayScalar x )
+{
+#if RAY_SCALAR == RAY_SCALAR_FIXED
+	return x != RAY_FIXED_MAX && x != RAY_FIXED_MIN;
+#else
+	return isfinite( x );
+#endif
+
+} // RayIsFinite()
+
+int RayIsNan( RayScalar x )
+{
+#if RAY_SCALAR == RAY_SCALAR_FIXED
+	return FALSE;
+#else
+	return isnan( x );
+#endif
+
+} // RayIsNan()
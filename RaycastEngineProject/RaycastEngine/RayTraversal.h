@@ -0,0 +1,324 @@
+#pragma once
+
+#include <math.h>
+#include "CustomMath.h"
+#include "Map.h"
+#include "RayScalar.h"
+
+// Ways of finding the wall each column sees, all giving the same Hit
+#define TRAVERSAL_SCALAR		0 // one cell per step
+#define TRAVERSAL_PACKET		1 // RAY_PACKET_SIZE columns per step in SIMD lanes
+#define TRAVERSAL_OCCUPANCY		2 // empty runs along a row or column skipped with the OccupancyGrid
+#define TRAVERSAL_DISTANCE		3 // empty squares around the ray leapt with the DistanceField
+#define TRAVERSAL_SWEEP			4 // no rays, wall faces in view swept into the columns ( see WallFaces.h )
+
+// Result of advancing a ray
+#define RAY_MARCHING			0
+#define RAY_HIT					1
+#define RAY_LEFT_MAP			2
+#define RAY_PAST_FAR			3 // the next crossing is beyond the far plane
+
+#define MIN_SKIP_RUN			4 // shorter runs are cheaper to step cell by cell
+#define MIN_LEAP_REACH			2 // smaller empty squares are cheaper to step cell by cell
+
+// DDA state of one ray. Side distances are kept in closed form ( start + steps * delta ) rather than
+// accumulated, so the state after any number of crossings can be computed directly and skipping is exact
+typedef struct
+{
+	Vec2	rayDir;
+	Vec2	mapPos; // start, in cells
+	RayVec2	deltaDist; //length of ray from one x or y-side to next x or y-side
+	RayVec2	sideStart; //length of ray from start position to first x or y-side
+	RayVec2	sideDist; //length of ray from start position to next x or y-side
+	VecI2	mapStep; //what direction to step in x or y-direction (either +1 or -1)
+	VecI2	steps; // crossings taken along each axis
+	RayScalar farDist; // no crossing with a larger side distance is taken, RAY_SCALAR_MAX when unbounded
+	int		mapX, mapY;
+	int		isSide;
+
+} RayState;
+
+// Side distance after 'steps' ( >= 1 ) crossings along one axis
+RayScalar SideDistAt( RayScalar start, RayScalar delta, int steps )
+{
+	return RayAdd( start, RayMulInt( delta, steps ) );
+
+} // SideDistAt()
+
+// World position where a ray ended after the given crossings
+Vec2 RayEndPos( Vec2 startPos, VecI2 steps, VecI2 mapStep )
+{
+	return vec2( startPos.x + steps.x * mapStep.x * GRID_RES.x, startPos.y + steps.y * mapStep.y * GRID_RES.y );
+
+} // RayEndPos()
+
+// Start a ray whose deltaDist is already known ( see ColumnRays )
+void InitRayStateDelta( RayState* ray, Vec2 mapPos, Vec2 rayDir, Vec2 deltaDist )
+{
+	memset( ray, 0, sizeof *ray );
+	ray->rayDir		= rayDir;
+	ray->mapPos		= mapPos;
+	ray->deltaDist	= RayVec2FromDouble( deltaDist );
+
+	// Truncate Map Pos
+	ray->mapX = (int)mapPos.x;
+	ray->mapY = (int)mapPos.y;
+
+	//calculate step and initial sideDist
+	if (rayDir.x < 0)
+	{
+		ray->mapStep.x		= -1;
+		ray->sideStart.x	= RayMul( RayFromDouble( mapPos.x - ray->mapX ), ray->deltaDist.x );
+	}
+	else
+	{
+		ray->mapStep.x		= 1;
+		ray->sideStart.x	= RayMul( RayFromDouble( ray->mapX + 1.0 - mapPos.x ), ray->deltaDist.x );
+	}
+	if (rayDir.y < 0)
+	{
+		ray->mapStep.y		= -1;
+		ray->sideStart.y	= RayMul( RayFromDouble( mapPos.y - ray->mapY ), ray->deltaDist.y );
+	}
+	else
+	{
+		ray->mapStep.y		= 1;
+		ray->sideStart.y	= RayMul( RayFromDouble( ray->mapY + 1.0 - mapPos.y ), ray->deltaDist.y );
+	}
+	ray->sideDist	= ray->sideStart;
+	ray->farDist	= RAY_SCALAR_MAX;
+
+} // InitRayStateDelta()
+
+void InitRayState( RayState* ray, Vec2 mapPos, Vec2 rayDir )
+{
+	Vec2 rayDirSquared	= { square(rayDir.x), square(rayDir.y) };
+	InitRayStateDelta( ray, mapPos, rayDir, vec2( sqrt(1 + rayDirSquared.y / rayDirSquared.x ), sqrt(1 + rayDirSquared.x / rayDirSquared.y ) ) );
+
+} // InitRayState()
+
+// Stop the ray at a perpendicular distance of 'depth' cells, side distances run along the unnormalized
+// direction whose length is 'dirLength'
+void SetRayFarPlane( RayState* ray, double depth, double dirLength )
+{
+	ray->farDist = RayFromDouble( depth * dirLength );
+
+} // SetRayFarPlane()
+
+int TestRayCell( RayState* ray, const GameMap* gameMap )
+{
+	if ( !IsInsideMap( gameMap, ray->mapX, ray->mapY ) )
+	{
+		return RAY_LEFT_MAP;
+	}
+
+	//Check if ray has hit a wall
+	return ( GetTile( gameMap, ray->mapX, ray->mapY ) > 0 ) ? RAY_HIT : RAY_MARCHING;
+
+} // TestRayCell()
+
+// One DDA step: jump to next map square, OR in x-direction, OR in y-direction
+int StepRay( RayState* ray, const GameMap* gameMap )
+{
+	if ( ray->sideDist.x < ray->sideDist.y )
+	{
+		ray->steps.x++;
+		ray->sideDist.x	= SideDistAt( ray->sideStart.x, ray->deltaDist.x, ray->steps.x );
+		ray->mapX		+= ray->mapStep.x;
+		ray->isSide		 = TRUE;
+	}
+	else
+	{
+		ray->steps.y++;
+		ray->sideDist.y	= SideDistAt( ray->sideStart.y, ray->deltaDist.y, ray->steps.y );
+		ray->mapY		+= ray->mapStep.y;
+		ray->isSide		 = FALSE;
+	}
+
+	return TestRayCell( ray, gameMap );
+
+} // StepRay()
+
+// How many crossings along one axis happen in a row ( 0..limit ), starting with the next one at 'steps'
+// whose side distance is 'current'. A crossing n is taken while SideDistAt(n) < target, or <= target when the axis wins ties
+int CountCrossings( RayScalar current, RayScalar start, RayScalar delta, int steps, RayScalar target, int winsTies, int limit )
+{
+	#define CROSSING( n )	( (n) == steps ? current : SideDistAt( start, delta, n ) )
+	#define TAKES( n )		( winsTies ? CROSSING( n ) <= target : CROSSING( n ) < target )
+	if ( limit <= 0 || !TAKES( steps ) )
+	{
+		return 0;
+	}
+
+	// Last crossing index that is still taken, found from an estimate and corrected with the exact test
+	const int FIRST	= steps;
+	const int LAST	= steps + limit - 1;
+	double estimate	= ( RayToDouble( target ) - RayToDouble( start ) ) / RayToDouble( delta );
+	int last		= ( estimate >= LAST ) ? LAST : ( estimate > FIRST ) ? (int)estimate : FIRST;
+
+	while ( last > FIRST && !TAKES( last ) )
+	{
+		last--;
+	}
+	while ( last < LAST && TAKES( last + 1 ) )
+	{
+		last++;
+	}
+	#undef TAKES
+	#undef CROSSING
+
+	return last - FIRST + 1;
+
+} // CountCrossings()
+
+// Nearly axis-aligned rays cross several cells along one axis per crossing of the other
+int HasLongRuns( const RayState* ray )
+{
+	double deltaX	= RayToDouble( ray->deltaDist.x );
+	double deltaY	= RayToDouble( ray->deltaDist.y );
+	return deltaY > MIN_SKIP_RUN * deltaX || deltaX > MIN_SKIP_RUN * deltaY;
+
+} // HasLongRuns()
+
+// Advance through a whole run of empty cells along the dominant axis at once, finding the first
+// solid cell with a bitscan. Ends in exactly the state StepRay() would reach cell by cell, which includes
+// stopping before the first crossing past the far plane
+int SkipEmptyRun( RayState* ray, const GameMap* gameMap )
+{
+	const OccupancyGrid* grid = &gameMap->occupancy;
+
+	// Only worth a scan if enough crossings along one axis come before the next one on the other
+	double sideX	= RayToDouble( ray->sideDist.x );
+	double sideY	= RayToDouble( ray->sideDist.y );
+	int runX		= sideY - sideX > MIN_SKIP_RUN * RayToDouble( ray->deltaDist.x );
+	int runY		= sideX - sideY > MIN_SKIP_RUN * RayToDouble( ray->deltaDist.y );
+	if ( !runX && !runY )
+	{
+		return StepRay( ray, gameMap );
+	}
+
+	// Non-finite distances ( axis-parallel rays, start on a grid line ) keep the plain step
+	int finite = RayIsFinite( ray->sideDist.x ) && RayIsFinite( ray->sideDist.y ) && RayIsFinite( ray->deltaDist.x ) && RayIsFinite( ray->deltaDist.y );
+	if ( !finite || !IsInsideMap( gameMap, ray->mapX, ray->mapY ) )
+	{
+		return StepRay( ray, gameMap );
+	}
+
+	if ( runX )
+	{
+		// The next y crossing ends the run, or the far plane before it ( a crossing exactly at farDist is still taken )
+		const int LIMIT		= ( ray->mapStep.x > 0 ) ? gameMap->width - ray->mapX : ray->mapX + 1; // last one leaves the map
+		const int FAR_FIRST	= ray->farDist < ray->sideDist.y;
+		int run				= CountCrossings( ray->sideDist.x, ray->sideStart.x, ray->deltaDist.x, ray->steps.x, FAR_FIRST ? ray->farDist : ray->sideDist.y, FAR_FIRST, LIMIT );
+		int from			= ray->mapX + ray->mapStep.x;
+		int to				= clampI( ray->mapX + ray->mapStep.x * run, 0, gameMap->width - 1 );
+		int solid			= ( from >= 0 && from < gameMap->width ) ? FindSolidInRow( grid, ray->mapY, from, to ) : -1;
+		int taken			= ( solid >= 0 ) ? abs( solid - ray->mapX ) : run;
+
+		ray->steps.x		+= taken;
+		ray->sideDist.x		 = SideDistAt( ray->sideStart.x, ray->deltaDist.x, ray->steps.x );
+		ray->mapX			+= ray->mapStep.x * taken;
+		ray->isSide			 = TRUE;
+	}
+	else
+	{
+		const int LIMIT		= ( ray->mapStep.y > 0 ) ? gameMap->height - ray->mapY : ray->mapY + 1;
+		int run				= CountCrossings( ray->sideDist.y, ray->sideStart.y, ray->deltaDist.y, ray->steps.y, min( ray->sideDist.x, ray->farDist ), TRUE, LIMIT );
+		int from			= ray->mapY + ray->mapStep.y;
+		int to				= clampI( ray->mapY + ray->mapStep.y * run, 0, gameMap->height - 1 );
+		int solid			= ( from >= 0 && from < gameMap->height ) ? FindSolidInColumn( grid, ray->mapX, from, to ) : -1;
+		int taken			= ( solid >= 0 ) ? abs( solid - ray->mapY ) : run;
+
+		ray->steps.y		+= taken;
+		ray->sideDist.y		 = SideDistAt( ray->sideStart.y, ray->deltaDist.y, ray->steps.y );
+		ray->mapY			+= ray->mapStep.y * taken;
+		ray->isSide			 = FALSE;
+	}
+
+	return TestRayCell( ray, gameMap );
+
+} // SkipEmptyRun()
+
+// Take every crossing inside the empty square the DistanceField guarantees around the current cell at once.
+// Ends in exactly the state StepRay() would reach cell by cell, just before the crossing that leaves the square
+int LeapEmptySquare( RayState* ray, const GameMap* gameMap )
+{
+	// Crossings along each axis that stay inside the square
+	const int REACH = GetWallDistance( &gameMap->distanceField, ray->mapX, ray->mapY ) - 1;
+	if ( REACH < MIN_LEAP_REACH || RayIsNan( ray->sideDist.x ) || RayIsNan( ray->sideDist.y ) )
+	{
+		return StepRay( ray, gameMap );
+	}
+
+	// Whichever axis leaves first ends the leap, the other one takes its crossings that come before that
+	RayScalar exitX	= SideDistAt( ray->sideStart.x, ray->deltaDist.x, ray->steps.x + REACH );
+	RayScalar exitY	= SideDistAt( ray->sideStart.y, ray->deltaDist.y, ray->steps.y + REACH );
+	int takenX		= REACH;
+	int takenY		= REACH;
+	if ( exitX < exitY )
+	{
+		takenY = CountCrossings( ray->sideDist.y, ray->sideStart.y, ray->deltaDist.y, ray->steps.y, exitX, TRUE, REACH );
+	}
+	else
+	{
+		takenX = CountCrossings( ray->sideDist.x, ray->sideStart.x, ray->deltaDist.x, ray->steps.x, exitY, FALSE, REACH );
+	}
+
+	// Nor past the far plane, where the ray ends right after the leap
+	if ( RayIsFinite( ray->farDist ) )
+	{
+		takenX = CountCrossings( ray->sideDist.x, ray->sideStart.x, ray->deltaDist.x, ray->steps.x, ray->farDist, TRUE, takenX );
+		takenY = CountCrossings( ray->sideDist.y, ray->sideStart.y, ray->deltaDist.y, ray->steps.y, ray->farDist, TRUE, takenY );
+	}
+
+	// Side of the last crossing taken, as StepRay() leaves it when the far plane ends the ray. Of two crossings at the
+	// same distance StepRay() takes the y one first
+	if ( takenX > 0 || takenY > 0 )
+	{
+		RayScalar lastX	= ( takenX > 1 ) ? SideDistAt( ray->sideStart.x, ray->deltaDist.x, ray->steps.x + takenX - 1 ) : ray->sideDist.x;
+		RayScalar lastY	= ( takenY > 1 ) ? SideDistAt( ray->sideStart.y, ray->deltaDist.y, ray->steps.y + takenY - 1 ) : ray->sideDist.y;
+		ray->isSide		= ( takenY == 0 ) || ( takenX > 0 && lastX >= lastY );
+	}
+
+	// Every cell passed is inside the square, so still empty and inside the map
+	if ( takenX > 0 )
+	{
+		ray->steps.x	+= takenX;
+		ray->sideDist.x	 = SideDistAt( ray->sideStart.x, ray->deltaDist.x, ray->steps.x );
+		ray->mapX		+= ray->mapStep.x * takenX;
+	}
+	if ( takenY > 0 )
+	{
+		ray->steps.y	+= takenY;
+		ray->sideDist.y	 = SideDistAt( ray->sideStart.y, ray->deltaDist.y, ray->steps.y );
+		ray->mapY		+= ray->mapStep.y * takenY;
+	}
+	return RAY_MARCHING;
+
+} // LeapEmptySquare()
+
+// Walk a ray until it hits a wall, leaves the map or reaches its far plane, adding the iterations it took to 'iterations' when given
+int WalkRay( RayState* ray, const GameMap* gameMap, int traversal, int* iterations )
+{
+	const int SKIP_RUNS	= ( traversal == TRAVERSAL_OCCUPANCY ) && HasLongRuns( ray );
+	const int LEAP		= ( traversal == TRAVERSAL_DISTANCE );
+	int status			= RAY_MARCHING;
+	int count			= 0;
+	while ( status == RAY_MARCHING )
+	{
+		if ( min( ray->sideDist.x, ray->sideDist.y ) > ray->farDist )
+		{
+			status = RAY_PAST_FAR;
+			break;
+		}
+		status = LEAP ? LeapEmptySquare( ray, gameMap ) : SKIP_RUNS ? SkipEmptyRun( ray, gameMap ) : StepRay( ray, gameMap );
+		count++;
+	}
+
+	if ( iterations != NULL )
+	{
+		*iterations += count;
+	}
+	return status;
+
+} // WalkRay()
@@ -0,0 +1,204 @@
+#pragma once
+
+#include "SDL.h"
+#include "CustomMath.h"
+
+#define MAX_WORKER_THREADS	64
+#define CACHE_LINE			64
+
+// Processes items [start, end) of a dispatch on the given worker
+typedef void (*PoolJob)( void* context, int start, int end, int worker );
+
+// Chunks owned by one worker, padded so neighbouring counters never share a cache line
+typedef struct
+{
+	SDL_atomic_t	next; // next chunk to hand out, owner and thieves both take from here
+	int				end;
+	char			padding[CACHE_LINE - sizeof(SDL_atomic_t) - sizeof(int)];
+
+} WorkRange;
+
+typedef struct
+{
+	struct ThreadPool*	pool;
+	int					index;
+
+} WorkerInfo;
+
+// Persistent workers, woken once per dispatch. The calling thread runs as worker 0
+typedef struct ThreadPool
+{
+	int				threadCount; // including the calling thread
+	int				isSerial; // dispatches run on the calling thread alone, see SetThreadPoolSerial()
+	SDL_Thread*		threads[MAX_WORKER_THREADS];
+	WorkerInfo		workers[MAX_WORKER_THREADS];
+	WorkRange		ranges[MAX_WORKER_THREADS];
+
+	SDL_mutex*		lock;
+	SDL_cond*		wake;
+	SDL_cond*		done;
+	int				generation;
+	int				pending;
+	int				quit;
+
+	// Current dispatch
+	PoolJob			job;
+	void*			context;
+	int				itemCount;
+	int				chunkSize;
+
+} ThreadPool;
+
+// Drain own chunks first, then steal from the other workers
+void RunPoolChunks( ThreadPool* pool, int worker )
+{
+	for ( int i = 0; i < pool->threadCount; i++ )
+	{
+		WorkRange* range = &pool->ranges[ ( worker + i ) % pool->threadCount ];
+		for ( ;; )
+		{
+			int chunk = SDL_AtomicAdd( &range->next, 1 );
+			if ( chunk >= range->end )
+			{
+				break;
+			}
+			int start	= chunk * pool->chunkSize;
+			int end		= min( start + pool->chunkSize, pool->itemCount );
+			pool->job( pool->context, start, end, worker );
+		}
+	}
+
+} // RunPoolChunks()
+
+int WorkerThread( void* data )
+{
+	WorkerInfo* info	= (WorkerInfo*)data;
+	ThreadPool* pool	= info->pool;
+	int seen			= 0;
+
+	SDL_LockMutex( pool->lock );
+	for ( ;; )
+	{
+		while ( pool->generation == seen && !pool->quit )
+		{
+			SDL_CondWait( pool->wake, pool->lock );
+		}
+		if ( pool->quit )
+		{
+			break;
+		}
+		seen = pool->generation;
+		SDL_UnlockMutex( pool->lock );
+
+		RunPoolChunks( pool, info->index );
+
+		SDL_LockMutex( pool->lock );
+		if ( --pool->pending == 0 )
+		{
+			SDL_CondSignal( pool->done );
+		}
+	}
+	SDL_UnlockMutex( pool->lock );
+	return 0;
+
+} // WorkerThread()
+
+// threadCount of 0 uses one thread per CPU core
+void CreateThreadPool( ThreadPool* pool, int threadCount )
+{
+	memset( pool, 0, sizeof *pool );
+	if ( threadCount <= 0 )
+	{
+		threadCount = SDL_GetCPUCount();
+	}
+	pool->threadCount	= clampI( threadCount, 1, MAX_WORKER_THREADS );
+	pool->lock			= SDL_CreateMutex();
+	pool->wake			= SDL_CreateCond();
+	pool->done			= SDL_CreateCond();
+
+	for ( int i = 1; i < pool->threadCount; i++ )
+	{
+		pool->workers[i].pool	= pool;
+		pool->workers[i].index	= i;
+		pool->threads[i]		= SDL_CreateThread( WorkerThread, "RaycastWorker", &pool->workers[i] );
+		if ( pool->threads[i] == NULL )
+		{
+			printf("Cannot create worker thread: %s \n\n", SDL_GetError() );
+			pool->threadCount = i;
+			break;
+		}
+	}
+
+} // CreateThreadPool()
+
+void DestroyThreadPool( ThreadPool* pool )
+{
+	if ( pool->lock == NULL )
+	{
+		return;
+	}
+
+	SDL_LockMutex( pool->lock );
+	pool->quit = TRUE;
+	SDL_CondBroadcast( pool->wake );
+	SDL_UnlockMutex( pool->lock );
+
+	for ( int i = 1; i < pool->threadCount; i++ )
+	{
+		SDL_WaitThread( pool->threads[i], NULL );
+	}
+	SDL_DestroyCond( pool->done );
+	SDL_DestroyCond( pool->wake );
+	SDL_DestroyMutex( pool->lock );
+	memset( pool, 0, sizeof *pool );
+
+} // DestroyThreadPool()
+
+// While isSerial is set the workers stay parked and every dispatch runs on the calling thread, in the same chunks.
+// Checks that frames do not depend on the thread count render once each way
+void SetThreadPoolSerial( ThreadPool* pool, int isSerial )
+{
+	pool->isSerial = isSerial;
+
+} // SetThreadPoolSerial()
+
+// Split itemCount items into chunks, hand each worker an even share and block until all are done
+void RunThreadPool( ThreadPool* pool, PoolJob job, void* context, int itemCount, int chunkSize )
+{
+	if ( pool->threadCount <= 1 || pool->isSerial )
+	{
+		// Same chunks as with workers, jobs like adaptive casting depend on the range bounds and frames must not depend on the core count
+		for ( int start = 0; start < itemCount; start += chunkSize )
+		{
+			job( context, start, min( start + chunkSize, itemCount ), 0 );
+		}
+		return;
+	}
+
+	const int CHUNK_COUNT = ( itemCount + chunkSize - 1 ) / chunkSize;
+	for ( int i = 0; i < pool->threadCount; i++ )
+	{
+		SDL_AtomicSet( &pool->ranges[i].next, ( CHUNK_COUNT * i ) / pool->threadCount );
+		pool->ranges[i].end = ( CHUNK_COUNT * ( i + 1 ) ) / pool->threadCount;
+	}
+
+	SDL_LockMutex( pool->lock );
+	pool->job		= job;
+	pool->context	= context;
+	pool->itemCount	= itemCount;
+	pool->chunkSize	= chunkSize;
+	pool->pending	= pool->threadCount - 1;
+	pool->generation++;
+	SDL_CondBroadcast( pool->wake );
+	SDL_UnlockMutex( pool->lock );
+
+	RunPoolChunks( pool, 0 );
+
+	SDL_LockMutex( pool->lock );
+	while ( pool->pending > 0 )
+	{
+		SDL_CondWait( pool->done, pool->lock );
+	}
+	SDL_UnlockMutex( pool->lock );
+
+} // RunThreadPool()
@@ -0,0 +1,274 @@
+#pragma once
+
+#include <stdlib.h>
+#include <string.h>
+#include <emmintrin.h>
+#include "SDL.h"
+#include "CustomMath.h"
+#include "Map.h"
+#include "Player.h"
+#include "ThreadPool.h"
+#include "ViewLabels.h"
+#include "GameState.h"
+
+// Vectorized environment for training agents: many Players over one loaded map, stepped in lockstep on the thread pool.
+// It drives the game's own renderer through GameState.h, whose functions Main.c defines
+
+#define ENV_STEP			( 1.0 / 30 ) // simulated seconds of one environment step
+#define ENV_CHUNK			4 // environment instances a worker takes at a time
+
+// Actions of an environment step, any combination of these bits. They press the keys a player would
+#define ACTION_FORWARD		0x01
+#define ACTION_BACKWARD		0x02
+#define ACTION_STRAFE_LEFT	0x04
+#define ACTION_STRAFE_RIGHT	0x08
+#define ACTION_TURN_LEFT	0x10
+#define ACTION_TURN_RIGHT	0x20
+#define ACTION_COUNT		64 // distinct actions
+
+// Observations beyond the per column labels, which are always made. Only OBSERVE_RGB samples textures
+#define OBSERVE_RGB			0x01 // the frame as the game draws it
+#define OBSERVE_LABELS		0x02 // per pixel labels, see LabelPixels()
+
+typedef struct
+{
+	int		instanceCount;
+	int		width; // of the observed view, every column is labelled
+	int		height; // rows of the RGB frame and pixel labels
+	int		observe; // OBSERVE_ bits
+	Uint32	seed; // of the positions and directions ResetVecEnv() picks
+
+} EnvConfig;
+
+// Observations of the last step or reset. Each array is contiguous over the instances, instance i's part at i times its size
+typedef struct
+{
+	ViewLabels	columns; // [instance][column], the ray length deep where no wall was hit
+	ViewLabels	pixels; // [instance][row][column], all NULL without OBSERVE_LABELS
+	Uint8*		rgb; // [instance][row][column] packed 8 bit RGB, NULL without OBSERVE_RGB
+
+} EnvObservations;
+
+// A pool worker's renderer context, the Player of the instance it works on is copied into its view
+typedef struct
+{
+	GameState	view;
+	Uint8		keys[SDL_NUM_SCANCODES]; // the instance's action as the keyboard state ProcessPlayerInput() reads
+
+} EnvWorker;
+
+// Independent Players over one shared GameMap, stepped in lockstep on the thread pool, see CreateVecEnv()
+typedef struct
+{
+	EnvConfig		config;
+	int				columnCount; // per instance
+	GameState		game; // loaded without a window, owns the shared map, textures and thread pool
+	SDL_Surface*	target; // of the software renderer the textures are loaded through
+	Player*			players; // one per instance
+	EnvWorker*		workers; // one per pool worker
+	int				workerCount;
+	const int*		actions; // of the step being run, NULL while resetting
+	Uint8*			storage; // all observation arrays, one allocation
+	EnvObservations	observations;
+	Uint32			random; // state of the resets
+
+} VecEnv;
+
+// xorshift32, resets repeat for the same seed on any machine
+Uint32 NextRandom( Uint32* state )
+{
+	Uint32 x	= *state;
+	x			^= x << 13;
+	x			^= x >> 17;
+	x			^= x << 5;
+	*state		= x;
+	return x;
+
+} // NextRandom()
+
+// Cast an instance's view with the worker's context and label it, textures are only sampled when RGB is observed
+void ObserveInstance( VecEnv* env, EnvWorker* worker, int instance )
+{
+	GameState* view			= &worker->view;
+	const size_t PIXELS		= (size_t)view->frameBuffer.width * view->frameBuffer.height;
+	view->player			= env->players[instance];
+	if ( env->observations.rgb != NULL )
+	{
+		RasterizeWorld( view );
+		PackFramebufferRGB( &view->frameBuffer, env->observations.rgb + instance * PIXELS * 3 );
+	}
+	else
+	{
+		CastColumns( view, env->columnCount );
+	}
+
+	ViewLabels columns = OffsetLabels( &env->observations.columns, (size_t)instance * env->columnCount );
+	LabelColumns( view->columnHits, env->columnCount, &view->gameMap, (float)view->gameMap.rayLength, &columns );
+	if ( env->observations.pixels.depth != NULL )
+	{
+		ViewLabels pixels = OffsetLabels( &env->observations.pixels, instance * PIXELS );
+		LabelPixels( view->columnHits, &view->gameMap, &columns, view->wallSpans, view->frameBuffer.width, view->frameBuffer.height, &pixels );
+	}
+
+} // ObserveInstance()
+
+// Environment job: move instances [start, end) by their actions, if stepping, and observe them
+void StepEnvRange(void *context, int start, int end, int worker)
+{
+	VecEnv* env		= (VecEnv*)context;
+	EnvWorker* self	= &env->workers[worker];
+	for (int i = start; i < end; i++)
+	{
+		if (env->actions != NULL)
+		{
+			const int ACTION					= env->actions[i];
+			self->keys[SDL_SCANCODE_W]			= (ACTION & ACTION_FORWARD) != 0;
+			self->keys[SDL_SCANCODE_S]			= (ACTION & ACTION_BACKWARD) != 0;
+			self->keys[SDL_SCANCODE_A]			= (ACTION & ACTION_STRAFE_LEFT) != 0;
+			self->keys[SDL_SCANCODE_D]			= (ACTION & ACTION_STRAFE_RIGHT) != 0;
+			self->keys[SDL_SCANCODE_LEFT]		= (ACTION & ACTION_TURN_LEFT) != 0;
+			self->keys[SDL_SCANCODE_RIGHT]		= (ACTION & ACTION_TURN_RIGHT) != 0;
+			ProcessPlayerInput(self->keys, &env->players[i], &env->game.gameMap, ENV_STEP);
+		}
+		ObserveInstance(env, self, i);
+	}
+
+} // StepEnvRange()
+
+// Next cache line aligned array of size bytes from storage at *used, only counted when storage is NULL
+void* CarveArray( Uint8* storage, size_t* used, size_t size )
+{
+	void* array	= ( storage != NULL && size > 0 ) ? storage + *used : NULL;
+	*used		+= ( size + CACHE_LINE - 1 ) / CACHE_LINE * CACHE_LINE;
+	return array;
+
+} // CarveArray()
+
+// Lay the observations the config asks for out in storage, returns the bytes they take
+size_t CarveObservations( VecEnv* env, Uint8* storage )
+{
+	const size_t COLUMNS	= (size_t)env->config.instanceCount * env->columnCount;
+	const size_t PIXELS		= (size_t)env->config.instanceCount * env->config.width * env->config.height;
+	const size_t LABELS[]	= { COLUMNS, ( env->config.observe & OBSERVE_LABELS ) ? PIXELS : 0 };
+	ViewLabels* TARGETS[]	= { &env->observations.columns, &env->observations.pixels };
+	size_t used				= 0;
+	for ( int i = 0; i < 2; i++ )
+	{
+		TARGETS[i]->depth	= CarveArray( storage, &used, sizeof(float) * LABELS[i] );
+		TARGETS[i]->cell	= CarveArray( storage, &used, sizeof(Sint32) * LABELS[i] );
+		TARGETS[i]->side	= CarveArray( storage, &used, LABELS[i] );
+		TARGETS[i]->tile	= CarveArray( storage, &used, LABELS[i] );
+		TARGETS[i]->surface	= CarveArray( storage, &used, LABELS[i] );
+	}
+	env->observations.rgb	= CarveArray( storage, &used, ( env->config.observe & OBSERVE_RGB ) ? PIXELS * 3 : 0 );
+	return used;
+
+} // CarveObservations()
+
+void DestroyVecEnv( VecEnv* env )
+{
+	if ( env == NULL )
+	{
+		return;
+	}
+	for ( int i = 0; env->workers != NULL && i < env->workerCount; i++ )
+	{
+		DestroyViewContext( &env->workers[i].view );
+	}
+	free( env->workers );
+	free( env->players );
+	_mm_free( env->storage );
+	UnloadGame( &env->game ); // SDL itself belongs to the caller
+	SDL_FreeSurface( env->target );
+	free( env );
+
+} // DestroyVecEnv()
+
+// Reinforcement learning environment: loads the game once without a window, then config->instanceCount Players share
+// its map and textures, and each pool worker gets a view context of the observed size. Everything steps need is
+// allocated here. NULL on failure. Per column labels are cheapest, pixel labels skip every texture, the RGB frame costs
+// a full rasterization. Neither RESOLUTION nor SDL's lifetime is touched, the host may run a window of its own
+VecEnv* CreateVecEnv( const EnvConfig* config )
+{
+	VecEnv* env = ( config->instanceCount > 0 && config->width > 0 && config->height > 0 ) ? calloc( 1, sizeof(VecEnv) ) : NULL;
+	if ( env == NULL )
+	{
+		return NULL;
+	}
+	env->config			= *config;
+	env->random			= ( config->seed != 0 ) ? config->seed : 1; // xorshift never leaves 0
+
+	SetupGameState( &env->game );
+	const VecI2 VIEW_SIZE	= { config->width, config->height };
+	env->target				= SDL_CreateRGBSurfaceWithFormat( 0, VIEW_SIZE.x, VIEW_SIZE.y, 32, SDL_PIXELFORMAT_ARGB8888 );
+	env->game.renderer		= ( env->target != NULL ) ? SDL_CreateSoftwareRenderer( env->target ) : NULL;
+	if ( env->game.renderer == NULL )
+	{
+		printf("Cannot create the environment's renderer! SDL Error: %s \n", SDL_GetError());
+		SDL_FreeSurface( env->target );
+		free( env );
+		return NULL;
+	}
+	LoadGame( &env->game, VIEW_SIZE );
+	env->columnCount		= config->width * (int)env->game.gameMap.columnRatio;
+
+	// Measure the observation arrays, then carve them out of a single allocation
+	const size_t STORAGE_SIZE	= CarveObservations( env, NULL );
+	env->storage				= _mm_malloc( STORAGE_SIZE, CACHE_LINE );
+	env->players			= calloc( config->instanceCount, sizeof(Player) );
+	env->workerCount		= max( env->game.threadPool.threadCount, 1 );
+	env->workers			= calloc( env->workerCount, sizeof(EnvWorker) );
+	int isReady				= env->storage != NULL && env->players != NULL && env->workers != NULL;
+	for ( int i = 0; i < env->workerCount && isReady; i++ )
+	{
+		isReady = CreateViewContext( &env->workers[i].view, &env->game, VIEW_SIZE );
+	}
+	if ( !isReady )
+	{
+		printf("Cannot create %d environments of %dx%d \n\n", config->instanceCount, VIEW_SIZE.x, VIEW_SIZE.y );
+		DestroyVecEnv( env );
+		return NULL;
+	}
+
+	CarveObservations( env, env->storage );
+	return env;
+
+} // CreateVecEnv()
+
+// Every Player restarts in a random empty cell facing a random direction, returns their first observations
+const EnvObservations* ResetVecEnv( VecEnv* env )
+{
+	GameMap* gameMap = &env->game.gameMap;
+	for ( int i = 0; i < env->config.instanceCount; i++ )
+	{
+		Player* player = &env->players[i];
+		InitializePlayer( player );
+		for ( int tries = 0; tries < 1024; tries++ ) // a map without space keeps the start position
+		{
+			int x = NextRandom( &env->random ) % gameMap->width;
+			int y = NextRandom( &env->random ) % gameMap->height;
+			if ( GetTile( gameMap, x, y ) == 0 )
+			{
+				player->pos = vec2( ( x + 0.5 ) * GRID_RES.x, ( y + 0.5 ) * GRID_RES.y );
+				break;
+			}
+		}
+		RotatePlayer( player, NextRandom( &env->random ) * ( 6.283185307179586 / 4294967296.0 ), 1.0 );
+	}
+
+	env->actions = NULL;
+	RunThreadPool( &env->game.threadPool, StepEnvRange, env, env->config.instanceCount, ENV_CHUNK );
+	return &env->observations;
+
+} // ResetVecEnv()
+
+// Apply actions[i], a combination of ACTION_ bits, to instance i for ENV_STEP seconds. Returns the new observations,
+// which stay valid until the next step or reset
+const EnvObservations* StepVecEnv( VecEnv* env, const int* actions )
+{
+	env->actions = actions;
+	RunThreadPool( &env->game.threadPool, StepEnvRange, env, env->config.instanceCount, ENV_CHUNK );
+	env->actions = NULL;
+	return &env->observations;
+
+} // StepVecEnv()
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <string.h>
+#include "SDL.h"
+#include "CustomMath.h"
+#include "Map.h"
+#include "Player.h"
+#include "FloorCasting.h"
+
+// What a label shows, per column only the first four occur
+#define SURFACE_NONE		0 // no wall, the ray left the map
+#define SURFACE_WALL		1 // a wall face, Hit.isSide FALSE
+#define SURFACE_WALL_SIDE	2 // a wall face, Hit.isSide TRUE
+#define SURFACE_FOG			3 // the far plane
+#define SURFACE_CEILING		4
+#define SURFACE_FLOOR		5
+
+#define NO_CELL				-1
+
+// Label arrays of a view, one value per column or per pixel ( row-major )
+typedef struct
+{
+	float*	depth; // perpendicular distance in map cells
+	Sint32*	cell; // ID of the wall's cell, y * map width + x, NO_CELL where no wall is seen
+	Uint8*	side; // Hit.isSide of the wall seen
+	Uint8*	tile; // map tile value of the wall seen, 0 elsewhere
+	Uint8*	surface; // SURFACE_ class
+
+} ViewLabels;
+
+// The same arrays moved on by count values, to the labels of the next instance or row
+ViewLabels OffsetLabels( const ViewLabels* labels, size_t count )
+{
+	ViewLabels moved = { labels->depth + count, labels->cell + count, labels->side + count, labels->tile + count, labels->surface + count };
+	return moved;
+
+} // OffsetLabels()
+
+// Per column labels straight from a frame's Hits, no pixel is touched. Columns without a wall are farDepth away
+void LabelColumns( const Hit* hits, int columnCount, const GameMap* gameMap, float farDepth, ViewLabels* columns )
+{
+	for ( int i = 0; i < columnCount; i++ )
+	{
+		const Hit* hit = &hits[i];
+		if ( hit->isHit )
+		{
+			columns->depth[i]	= (float)hit->dist;
+			columns->cell[i]	= hit->point.y * gameMap->width + hit->point.x;
+			columns->side[i]	= (Uint8)hit->isSide;
+			columns->tile[i]	= GetTile( gameMap, hit->point.x, hit->point.y );
+			columns->surface[i]	= hit->isSide ? SURFACE_WALL_SIDE : SURFACE_WALL;
+		}
+		else
+		{
+			columns->depth[i]	= farDepth;
+			columns->cell[i]	= NO_CELL;
+			columns->side[i]	= 0;
+			columns->tile[i]	= 0;
+			columns->surface[i]	= hit->isFog ? SURFACE_FOG : SURFACE_NONE;
+		}
+	}
+
+} // LabelColumns()
+
+// Ceiling or floor over pixels [start, end) of a row
+void FillBackgroundRun( const ViewLabels* row, int start, int end, float depth, Uint8 surface )
+{
+	for ( int x = start; x < end; x++ )
+	{
+		row->depth[x] = depth;
+	}
+	memset( row->cell + start, 0xFF, sizeof(Sint32) * ( end - start ) ); // NO_CELL in every byte
+	memset( row->side + start, 0, end - start );
+	memset( row->tile + start, 0, end - start );
+	memset( row->surface + start, surface, end - start );
+
+} // FillBackgroundRun()
+
+// Wall labels of pixels [start, end) of a row, one column per pixel
+void CopyColumnRun( const ViewLabels* row, const ViewLabels* columns, int start, int end )
+{
+	memcpy( row->depth + start, columns->depth + start, sizeof(float) * ( end - start ) );
+	memcpy( row->cell + start, columns->cell + start, sizeof(Sint32) * ( end - start ) );
+	memcpy( row->side + start, columns->side + start, end - start );
+	memcpy( row->tile + start, columns->tile + start, end - start );
+	memcpy( row->surface + start, columns->surface + start, end - start );
+
+} // CopyColumnRun()
+
+// Per pixel labels of a width x height view, without sampling a texture. Each column's wall or fog covers the rows the
+// Framebuffer path projects it to and repeats that column's labels, the rows around it are ceiling and floor at their
+// row's distance. spans is scratch for width columns
+void LabelPixels( const Hit* hits, const GameMap* gameMap, const ViewLabels* columns, WallSpan* spans, int width, int height, ViewLabels* pixels )
+{
+	const int COLUMN_WIDTH	= (int)gameMap->columnRatio;
+	const int HALF_HEIGHT	= height / 2;
+
+	// Project every column once, as RenderColumnSoftware() and DrawFog() do
+	for ( int x = 0; x < width; x++ )
+	{
+		const Hit* hit		= &hits[x / COLUMN_WIDTH];
+		const double DIST	= hit->isHit ? hit->dist : hit->isFog ? gameMap->rayLength : 0;
+		int columnHeight	= ( DIST > 0 ) ? (int)( height / gameMap->wallScale / DIST ) : 0;
+		int top				= HALF_HEIGHT - columnHeight / 2;
+		spans[x].top		= ( columnHeight > 0 ) ? clampI( top, 0, height ) : 0;
+		spans[x].bottom		= ( columnHeight > 0 ) ? clampI( top + columnHeight, 0, height ) : 0;
+	}
+
+	// Row by row, so every array is written in order
+	for ( int y = 0; y < height; y++ )
+	{
+		const int IS_FLOOR		= ( y >= HALF_HEIGHT );
+		const int ROW			= IS_FLOOR ? y - HALF_HEIGHT : HALF_HEIGHT - 1 - y; // ceiling rows mirror the floor's
+		const float ROW_DEPTH	= (float)( height / ( 2.0 * gameMap->wallScale * ( ROW + 0.5 ) ) );
+		const Uint8 BACKGROUND	= IS_FLOOR ? SURFACE_FLOOR : SURFACE_CEILING;
+		ViewLabels row			= OffsetLabels( pixels, (size_t)y * width );
+
+		// Runs of wall and background, filled a run at a time instead of branching per pixel
+		if ( COLUMN_WIDTH == 1 )
+		{
+			for ( int x = 0; x < width; )
+			{
+				const int IS_WALL	= ( y >= spans[x].top && y < spans[x].bottom );
+				int end				= x + 1;
+				while ( end < width && ( y >= spans[end].top && y < spans[end].bottom ) == IS_WALL )
+				{
+					end++;
+				}
+				if ( IS_WALL )
+				{
+					CopyColumnRun( &row, columns, x, end );
+				}
+				else
+				{
+					FillBackgroundRun( &row, x, end, ROW_DEPTH, BACKGROUND );
+				}
+				x = end;
+			}
+			continue;
+		}
+
+		for ( int x = 0; x < width; x++ )
+		{
+			const int COLUMN = x / COLUMN_WIDTH;
+			if ( y >= spans[x].top && y < spans[x].bottom )
+			{
+				row.depth[x]	= columns->depth[COLUMN];
+				row.cell[x]		= columns->cell[COLUMN];
+				row.side[x]		= columns->side[COLUMN];
+				row.tile[x]		= columns->tile[COLUMN];
+				row.surface[x]	= columns->surface[COLUMN];
+			}
+			else
+			{
+				row.depth[x]	= ROW_DEPTH;
+				row.cell[x]		= NO_CELL;
+				row.side[x]		= 0;
+				row.tile[x]		= 0;
+				row.surface[x]	= BACKGROUND;
+			}
+		}
+	}
+
+} // LabelPixels()
@@ -0,0 +1,370 @@
+#pragma once
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "SDL.h"
+#include "CustomMath.h"
+#include "Map.h"
+
+#define FACE_EPSILON	1e-9 // in cells
+
+// One run of wall cell sides along a grid line that can be seen from an empty cell
+typedef struct
+{
+	int		isSide; // TRUE: on the line x = line, reached by an x-step ( same meaning as Hit.isSide )
+	int		line; // grid line the face lies on
+	int		start, end; // cells covered along the line, [start, end)
+	int		facing; // +1 when seen from the positive side of the line ( wall cells at line - 1 ), -1 otherwise
+
+} WallFace;
+
+// Nearest face found for one column
+typedef struct
+{
+	double	depth; // distance along the column's ray direction, INFINITY when nothing was found
+	int		mapX, mapY; // wall cell
+	int		isSide;
+
+} ColumnFace;
+
+// Wall faces of a GameMap and the per-column results of sweeping them
+typedef struct
+{
+	// Faces bucketed by map chunk, chunk i owns faces[ chunkStart[i] .. chunkStart[i + 1] )
+	WallFace*	faces;
+	int*		chunkStart;
+	int			faceCount, faceCapacity;
+	int			chunksX, chunksY;
+	int			revision; // GameMap revision the faces were extracted from, -1 when none
+
+	// Per column inputs and results
+	int			columnCount;
+	Vec2*		rayDirs;
+	ColumnFace*	columns;
+
+} WallSweep;
+
+int AllocateSweepColumns( WallSweep* sweep, int columnCount )
+{
+	free( sweep->rayDirs );
+	free( sweep->columns );
+	sweep->revision		= -1;
+	sweep->columnCount	= columnCount;
+	sweep->rayDirs		= malloc( sizeof(Vec2) * columnCount );
+	sweep->columns		= malloc( sizeof(ColumnFace) * columnCount );
+	return sweep->rayDirs != NULL && sweep->columns != NULL;
+
+} // AllocateSweepColumns()
+
+void FreeWallSweep( WallSweep* sweep )
+{
+	free( sweep->faces );
+	free( sweep->chunkStart );
+	free( sweep->rayDirs );
+	free( sweep->columns );
+	memset( sweep, 0, sizeof *sweep );
+
+} // FreeWallSweep()
+
+int IsEmptyCell( const GameMap* gameMap, int x, int y )
+{
+	return IsInsideMap( gameMap, x, y ) && !IsOccupied( &gameMap->occupancy, x, y );
+
+} // IsEmptyCell()
+
+void AddWallFace( WallSweep* sweep, WallFace face )
+{
+	if ( sweep->faceCount == sweep->faceCapacity )
+	{
+		sweep->faceCapacity	= max( sweep->faceCapacity * 2, 1024 );
+		sweep->faces		= realloc( sweep->faces, sizeof(WallFace) * sweep->faceCapacity );
+		if ( sweep->faces == NULL )
+		{
+			printf("Cannot allocate wall faces \n\n");
+			exit(1);
+		}
+	}
+	sweep->faces[ sweep->faceCount++ ] = face;
+
+} // AddWallFace()
+
+// Sides of wall cells in one chunk facing empty cells, consecutive ones along a line merged into one face.
+// Sides towards the outside of the map are left out, rays leave the map there without a hit
+void ExtractChunkFaces( WallSweep* sweep, const GameMap* gameMap, int chunkX, int chunkY )
+{
+	const int X0 = chunkX * MAP_CHUNK_SIZE;
+	const int Y0 = chunkY * MAP_CHUNK_SIZE;
+	const int X1 = min( X0 + MAP_CHUNK_SIZE, gameMap->width );
+	const int Y1 = min( Y0 + MAP_CHUNK_SIZE, gameMap->height );
+
+	// Left and right sides run along y
+	for ( int x = X0; x < X1; x++ )
+	{
+		for ( int facing = -1; facing <= 1; facing += 2 )
+		{
+			int runStart = -1;
+			for ( int y = Y0; y <= Y1; y++ )
+			{
+				int visible = y < Y1 && IsOccupied( &gameMap->occupancy, x, y ) && IsEmptyCell( gameMap, x + facing, y );
+				if ( visible && runStart < 0 )
+				{
+					runStart = y;
+				}
+				else if ( !visible && runStart >= 0 )
+				{
+					AddWallFace( sweep, (WallFace) { TRUE, ( facing > 0 ) ? x + 1 : x, runStart, y, facing } );
+					runStart = -1;
+				}
+			}
+		}
+	}
+
+	// Top and bottom sides run along x
+	for ( int y = Y0; y < Y1; y++ )
+	{
+		for ( int facing = -1; facing <= 1; facing += 2 )
+		{
+			int runStart = -1;
+			for ( int x = X0; x <= X1; x++ )
+			{
+				int visible = x < X1 && IsOccupied( &gameMap->occupancy, x, y ) && IsEmptyCell( gameMap, x, y + facing );
+				if ( visible && runStart < 0 )
+				{
+					runStart = x;
+				}
+				else if ( !visible && runStart >= 0 )
+				{
+					AddWallFace( sweep, (WallFace) { FALSE, ( facing > 0 ) ? y + 1 : y, runStart, x, facing } );
+					runStart = -1;
+				}
+			}
+		}
+	}
+
+} // ExtractChunkFaces()
+
+// Extract the faces once, and again only after the map has changed
+void ExtractWallFaces( WallSweep* sweep, const GameMap* gameMap )
+{
+	if ( sweep->revision == gameMap->revision )
+	{
+		return;
+	}
+
+	const int CHUNK_COUNT = gameMap->chunksX * gameMap->chunksY;
+	free( sweep->chunkStart );
+	sweep->chunkStart	= malloc( sizeof(int) * ( CHUNK_COUNT + 1 ) );
+	sweep->chunksX		= gameMap->chunksX;
+	sweep->chunksY		= gameMap->chunksY;
+	sweep->faceCount	= 0;
+	if ( sweep->chunkStart == NULL )
+	{
+		printf("Cannot allocate wall faces \n\n");
+		exit(1);
+	}
+
+	for ( int chunk = 0; chunk < CHUNK_COUNT; chunk++ )
+	{
+		sweep->chunkStart[chunk] = sweep->faceCount;
+		ExtractChunkFaces( sweep, gameMap, chunk % gameMap->chunksX, chunk / gameMap->chunksX );
+	}
+	sweep->chunkStart[CHUNK_COUNT]	= sweep->faceCount;
+	sweep->revision					= gameMap->revision;
+
+} // ExtractWallFaces()
+
+// Camera coordinate ( -1..1 across the view ) of a point relative to the camera, with its depth along the view direction
+double ProjectCameraCoord( Vec2 point, Vec2 direction, Vec2 cameraPlane, double* depth )
+{
+	double det	= direction.x * cameraPlane.y - direction.y * cameraPlane.x;
+	*depth		= ( point.x * cameraPlane.y - point.y * cameraPlane.x ) / det;
+	return ( ( direction.x * point.y - direction.y * point.x ) / det ) / *depth;
+
+} // ProjectCameraCoord()
+
+// Columns [*first, *last] a segment relative to the camera may cover, FALSE when it is out of view
+int ProjectSegmentColumns( const WallSweep* sweep, Vec2 from, Vec2 to, Vec2 direction, Vec2 cameraPlane, int* first, int* last )
+{
+	const double NEAR = 1e-6;
+	double depthFrom, depthTo;
+	ProjectCameraCoord( from, direction, cameraPlane, &depthFrom );
+	ProjectCameraCoord( to, direction, cameraPlane, &depthTo );
+	if ( depthFrom <= NEAR && depthTo <= NEAR )
+	{
+		return FALSE;
+	}
+
+	// Clip the part behind the camera
+	if ( depthFrom <= NEAR || depthTo <= NEAR )
+	{
+		double s	= ( NEAR - depthFrom ) / ( depthTo - depthFrom );
+		Vec2 cut	= vec2( from.x + ( to.x - from.x ) * s, from.y + ( to.y - from.y ) * s );
+		if ( depthFrom <= NEAR )
+		{
+			from = cut;
+		}
+		else
+		{
+			to = cut;
+		}
+	}
+
+	double depth;
+	double camFrom	= ProjectCameraCoord( from, direction, cameraPlane, &depth );
+	double camTo	= ProjectCameraCoord( to, direction, cameraPlane, &depth );
+	double columnA	= ( min( camFrom, camTo ) + 1 ) * sweep->columnCount / 2;
+	double columnB	= ( max( camFrom, camTo ) + 1 ) * sweep->columnCount / 2;
+	if ( columnB < -1 || columnA > sweep->columnCount + 1 )
+	{
+		return FALSE;
+	}
+
+	// One column of slack, each column is tested exactly against its own ray afterwards
+	*first	= (int)max( floor( columnA ) - 1, 0.0 );
+	*last	= (int)min( ceil( columnB ) + 1, sweep->columnCount - 1.0 );
+	return *first <= *last;
+
+} // ProjectSegmentColumns()
+
+// Keep the face for every column in range whose ray meets it nearer than what it has so far
+void RasterizeFace( WallSweep* sweep, const WallFace* face, Vec2 mapPos, int first, int last )
+{
+	for ( int column = first; column <= last; column++ )
+	{
+		Vec2 rayDir			= sweep->rayDirs[column];
+		ColumnFace* result	= &sweep->columns[column];
+		double across		= face->isSide ? rayDir.x : rayDir.y;
+		if ( across == 0 )
+		{
+			continue;
+		}
+
+		double depth = ( face->line - ( face->isSide ? mapPos.x : mapPos.y ) ) / across;
+		if ( depth <= 0 || depth >= result->depth )
+		{
+			continue;
+		}
+
+		// Ends taken with a little slack, so rays through the exact corner between two faces can't slip past both
+		double along = face->isSide ? mapPos.y + depth * rayDir.y : mapPos.x + depth * rayDir.x;
+		if ( along < face->start - FACE_EPSILON || along > face->end + FACE_EPSILON )
+		{
+			continue;
+		}
+
+		int wall		= ( face->facing > 0 ) ? face->line - 1 : face->line;
+		int cell		= clampI( (int)floor( along ), face->start, face->end - 1 );
+		result->depth	= depth;
+		result->isSide	= face->isSide;
+		result->mapX	= face->isSide ? wall : cell;
+		result->mapY	= face->isSide ? cell : wall;
+	}
+
+} // RasterizeFace()
+
+// Visible faces of one chunk into the columns they cover
+void SweepChunk( WallSweep* sweep, int chunk, Vec2 mapPos, Vec2 direction, Vec2 cameraPlane )
+{
+	for ( int i = sweep->chunkStart[chunk]; i < sweep->chunkStart[chunk + 1]; i++ )
+	{
+		const WallFace* face = &sweep->faces[i];
+
+		// Back faces
+		double side = ( face->isSide ? mapPos.x : mapPos.y ) - face->line;
+		if ( side * face->facing <= 0 )
+		{
+			continue;
+		}
+
+		Vec2 from	= face->isSide ? vec2( face->line, face->start ) : vec2( face->start, face->line );
+		Vec2 to		= face->isSide ? vec2( face->line, face->end ) : vec2( face->end, face->line );
+		int first, last;
+		if ( ProjectSegmentColumns( sweep, vec2( from.x - mapPos.x, from.y - mapPos.y ), vec2( to.x - mapPos.x, to.y - mapPos.y ), direction, cameraPlane, &first, &last ) )
+		{
+			RasterizeFace( sweep, face, mapPos, first, last );
+		}
+	}
+
+} // SweepChunk()
+
+// Whether any part of a chunk can be in front of the camera and between the view edges
+int IsChunkInView( const GameMap* gameMap, int chunkX, int chunkY, Vec2 mapPos, Vec2 direction, Vec2 cameraPlane )
+{
+	const double X0 = chunkX * MAP_CHUNK_SIZE - mapPos.x;
+	const double Y0 = chunkY * MAP_CHUNK_SIZE - mapPos.y;
+	const Vec2 CORNERS[4] = { { X0, Y0 }, { X0 + MAP_CHUNK_SIZE, Y0 }, { X0, Y0 + MAP_CHUNK_SIZE }, { X0 + MAP_CHUNK_SIZE, Y0 + MAP_CHUNK_SIZE } };
+
+	int behind = 0, left = 0, right = 0;
+	for ( int i = 0; i < 4; i++ )
+	{
+		double depth;
+		double cam	= ProjectCameraCoord( CORNERS[i], direction, cameraPlane, &depth );
+		behind		+= ( depth <= 0 );
+		left		+= ( depth > 0 && cam < -1 );
+		right		+= ( depth > 0 && cam > 1 );
+	}
+
+	// A corner behind the camera means the chunk may wrap around the view edges
+	return behind < 4 && ( behind > 0 || ( left < 4 && right < 4 ) );
+
+} // IsChunkInView()
+
+// Find the nearest wall face of every column: chunks are swept in rings outwards from the camera, only those
+// in view, and the sweep stops once every column has a face nearer than anything the next ring could hold,
+// or the next ring lies entirely past the far plane at depth 'farDepth' ( INFINITY for none )
+void SweepWallFaces( WallSweep* sweep, const GameMap* gameMap, Vec2 mapPos, Vec2 direction, Vec2 cameraPlane, double farDepth )
+{
+	ExtractWallFaces( sweep, gameMap );
+	for ( int i = 0; i < sweep->columnCount; i++ )
+	{
+		sweep->columns[i].depth = INFINITY;
+	}
+
+	// Longest ray direction, to turn a distance in cells into the smallest depth it can have
+	Vec2 edgeA				= sweep->rayDirs[0];
+	Vec2 edgeB				= sweep->rayDirs[sweep->columnCount - 1];
+	const double MAX_LENGTH	= sqrt( max( square( edgeA.x ) + square( edgeA.y ), square( edgeB.x ) + square( edgeB.y ) ) );
+
+	const int CENTER_X		= clampI( (int)mapPos.x >> MAP_CHUNK_BITS, 0, sweep->chunksX - 1 );
+	const int CENTER_Y		= clampI( (int)mapPos.y >> MAP_CHUNK_BITS, 0, sweep->chunksY - 1 );
+	const int RINGS			= max( max( CENTER_X, sweep->chunksX - 1 - CENTER_X ), max( CENTER_Y, sweep->chunksY - 1 - CENTER_Y ) );
+	for ( int ring = 0; ring <= RINGS; ring++ )
+	{
+		for ( int chunkY = max( CENTER_Y - ring, 0 ); chunkY <= min( CENTER_Y + ring, sweep->chunksY - 1 ); chunkY++ )
+		{
+			int onEdge	= ( chunkY == CENTER_Y - ring || chunkY == CENTER_Y + ring );
+			int stepX	= ( onEdge || ring == 0 ) ? 1 : 2 * ring;
+			for ( int chunkX = CENTER_X - ring; chunkX <= CENTER_X + ring; chunkX += stepX )
+			{
+				if ( chunkX < 0 || chunkX >= sweep->chunksX )
+				{
+					continue;
+				}
+				int chunk = chunkY * sweep->chunksX + chunkX;
+				if ( sweep->chunkStart[chunk] != sweep->chunkStart[chunk + 1] && IsChunkInView( gameMap, chunkX, chunkY, mapPos, direction, cameraPlane ) )
+				{
+					SweepChunk( sweep, chunk, mapPos, direction, cameraPlane );
+				}
+			}
+		}
+
+		// Everything in the next ring is at least this far away along any ray
+		double gap = min( min( mapPos.x - ( CENTER_X - ring ) * MAP_CHUNK_SIZE, ( CENTER_X + ring + 1 ) * MAP_CHUNK_SIZE - mapPos.x ),
+						  min( mapPos.y - ( CENTER_Y - ring ) * MAP_CHUNK_SIZE, ( CENTER_Y + ring + 1 ) * MAP_CHUNK_SIZE - mapPos.y ) );
+		if ( farDepth * MAX_LENGTH < gap )
+		{
+			break;
+		}
+		double farthest = 0;
+		for ( int i = 0; i < sweep->columnCount && farthest * MAX_LENGTH <= gap; i++ )
+		{
+			farthest = max( farthest, sweep->columns[i].depth );
+		}
+		if ( farthest * MAX_LENGTH <= gap )
+		{
+			break;
+		}
+	}
+
+} // SweepWallFaces()